@@ -0,0 +1,333 @@
+/**
+ * @file affinity.c
+ * @brief Source utility file to pin worker threads and processes to CPUs.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Three policies are supported:
+ *   compact - fill every CPU of one socket before moving to the next.
+ *   scatter - deal workers round-robin across sockets.
+ *   a list  - explicit CPU ids, e.g. "0,2,4-7", handed out in order.
+ *
+ * Socket membership is read from sysfs. If it is not available, every CPU is
+ * treated as belonging to socket 0, so compact and scatter degrade to the
+ * order of the current affinity mask.
+ */
+
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "affinity.h"
+
+
+typedef struct
+{
+    int cpu;
+    int package;
+    int indexInPackage;
+} CpuInfo;
+
+
+static int readPackageId(int cpu)
+{
+    char path[128];
+    snprintf(path, sizeof(path),
+        "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return 0;
+    }
+
+    int package = 0;
+    if (fscanf(file, "%d", &package) != 1 || package < 0)
+    {
+        package = 0;
+    }
+    fclose(file);
+    return package;
+}
+
+static int compareCompact(const void* a, const void* b)
+{
+    const CpuInfo* left = (const CpuInfo*) a;
+    const CpuInfo* right = (const CpuInfo*) b;
+    if (left->package != right->package)
+    {
+        return left->package - right->package;
+    }
+    return left->cpu - right->cpu;
+}
+
+static int compareScatter(const void* a, const void* b)
+{
+    const CpuInfo* left = (const CpuInfo*) a;
+    const CpuInfo* right = (const CpuInfo*) b;
+    if (left->indexInPackage != right->indexInPackage)
+    {
+        return left->indexInPackage - right->indexInPackage;
+    }
+    if (left->package != right->package)
+    {
+        return left->package - right->package;
+    }
+    return left->cpu - right->cpu;
+}
+
+// Builds the CPU order for the compact and scatter policies from the CPUs we
+// are currently allowed to run on.
+static int orderAvailableCpus(Affinity* affinity)
+{
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) != 0)
+    {
+        perror("sched_getaffinity() error");
+        return -1;
+    }
+
+    int count = CPU_COUNT(&available);
+    CpuInfo* info = (CpuInfo*) malloc(sizeof(CpuInfo) * (unsigned long) count);
+    if (info == NULL)
+    {
+        return -1;
+    }
+
+    int n = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && n < count; cpu++)
+    {
+        if (CPU_ISSET((size_t) cpu, &available))
+        {
+            info[n].cpu = cpu;
+            info[n].package = readPackageId(cpu);
+            info[n].indexInPackage = 0;
+            n++;
+        }
+    }
+
+    // CPUs are visited in ascending order, so counting the earlier CPUs on the
+    // same package gives the position of each CPU within its socket.
+    for (int i = 0; i < n; i++)
+    {
+        for (int ii = 0; ii < i; ii++)
+        {
+            if (info[ii].package == info[i].package)
+            {
+                info[i].indexInPackage++;
+            }
+        }
+    }
+
+    qsort(info, (unsigned long) n, sizeof(CpuInfo),
+        affinity->policy == AFFINITY_SCATTER ? compareScatter :
+        compareCompact);
+
+    affinity->cpus = (int*) malloc(sizeof(int) * (unsigned long) n);
+    if (affinity->cpus == NULL)
+    {
+        free(info);
+        return -1;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        affinity->cpus[i] = info[i].cpu;
+    }
+    affinity->count = n;
+
+    free(info);
+    return 0;
+}
+
+// Parses an explicit list such as "0,2,4-7".
+static int parseCpuList(Affinity* affinity, const char* spec)
+{
+    // Ranges are expanded into individual CPUs, so grow the array as needed.
+    int capacity = 16;
+    affinity->cpus = (int*) malloc(sizeof(int) * (unsigned long) capacity);
+    affinity->count = 0;
+    if (affinity->cpus == NULL)
+    {
+        return -1;
+    }
+
+    const char* cursor = spec;
+    while (*cursor != '\0')
+    {
+        char* end;
+        long first = strtol(cursor, &end, 10);
+        if (end == cursor || first < 0 || first >= CPU_SETSIZE)
+        {
+            return -1;
+        }
+        long last = first;
+        cursor = end;
+        if (*cursor == '-')
+        {
+            cursor++;
+            last = strtol(cursor, &end, 10);
+            if (end == cursor || last < first || last >= CPU_SETSIZE)
+            {
+                return -1;
+            }
+            cursor = end;
+        }
+
+        for (long cpu = first; cpu <= last; cpu++)
+        {
+            if (affinity->count == capacity)
+            {
+                capacity *= 2;
+                int* grown = (int*) realloc(affinity->cpus, sizeof(int) *
+                    (unsigned long) capacity);
+                if (grown == NULL)
+                {
+                    return -1;
+                }
+                affinity->cpus = grown;
+            }
+            affinity->cpus[affinity->count++] = (int) cpu;
+        }
+
+        if (*cursor == ',')
+        {
+            cursor++;
+        }
+        else if (*cursor != '\0')
+        {
+            return -1;
+        }
+    }
+
+    return affinity->count > 0 ? 0 : -1;
+}
+
+int parseAffinity(Affinity* affinity, const char* spec)
+{
+    affinity->policy = AFFINITY_NONE;
+    affinity->cpus = NULL;
+    affinity->count = 0;
+
+    int ok;
+    if (strcmp(spec, "none") == 0)
+    {
+        return 0;
+    }
+    else if (strcmp(spec, "compact") == 0)
+    {
+        affinity->policy = AFFINITY_COMPACT;
+        ok = orderAvailableCpus(affinity);
+    }
+    else if (strcmp(spec, "scatter") == 0)
+    {
+        affinity->policy = AFFINITY_SCATTER;
+        ok = orderAvailableCpus(affinity);
+    }
+    else
+    {
+        affinity->policy = AFFINITY_LIST;
+        ok = parseCpuList(affinity, spec);
+    }
+
+    if (ok != 0)
+    {
+        freeAffinity(affinity);
+        return -1;
+    }
+    return 0;
+}
+
+const char* affinityPolicyName(AffinityPolicy policy)
+{
+    switch (policy)
+    {
+        case AFFINITY_COMPACT:
+            return "compact";
+        case AFFINITY_SCATTER:
+            return "scatter";
+        case AFFINITY_LIST:
+            return "list";
+        default:
+            return "none";
+    }
+}
+
+// Returns the CPU for the given worker index, or -1 if it should not be
+// pinned. When there are more workers than CPUs, the order wraps around.
+int affinityCpuFor(const Affinity* affinity, int index)
+{
+    if (affinity->policy == AFFINITY_NONE || affinity->count == 0)
+    {
+        return -1;
+    }
+    return affinity->cpus[index % affinity->count];
+}
+
+int pinCurrentThread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((size_t) cpu, &set);
+
+    int ok = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ok != 0)
+    {
+        errno = ok;
+        perror("pthread_setaffinity_np() error");
+        return -1;
+    }
+    return 0;
+}
+
+// Linux applies sched_setaffinity to a single thread, so walk every task of
+// the process. This also catches helper threads that libraries (e.g. the MPI
+// progress engine) have already started.
+int pinCurrentProcess(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET((size_t) cpu, &set);
+
+    DIR* tasks = opendir("/proc/self/task");
+    if (tasks == NULL)
+    {
+        if (sched_setaffinity(0, sizeof(set), &set) != 0)
+        {
+            perror("sched_setaffinity() error");
+            return -1;
+        }
+        return 0;
+    }
+
+    struct dirent* entry;
+    int ok = 0;
+    while ((entry = readdir(tasks)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+        pid_t tid = (pid_t) atoi(entry->d_name);
+        if (sched_setaffinity(tid, sizeof(set), &set) != 0)
+        {
+            perror("sched_setaffinity() error");
+            ok = -1;
+        }
+    }
+    closedir(tasks);
+    return ok;
+}
+
+void freeAffinity(Affinity* affinity)
+{
+    free(affinity->cpus);
+    affinity->cpus = NULL;
+    affinity->count = 0;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file affinity.h
+ * @brief Header utility file to pin worker threads and processes to CPUs.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+
+typedef enum
+{
+    AFFINITY_NONE,
+    AFFINITY_COMPACT,
+    AFFINITY_SCATTER,
+    AFFINITY_LIST
+} AffinityPolicy;
+
+typedef struct
+{
+    AffinityPolicy policy;
+    // CPUs in the order they are handed out to workers.
+    int* cpus;
+    int count;
+} Affinity;
+
+
+int parseAffinity(Affinity* affinity, const char* spec);
+
+const char* affinityPolicyName(AffinityPolicy policy);
+
+int affinityCpuFor(const Affinity* affinity, int index);
+
+int pinCurrentThread(int cpu);
+
+int pinCurrentProcess(int cpu);
+
+void freeAffinity(Affinity* affinity);
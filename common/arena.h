@@ -0,0 +1,53 @@
+/**
+ * @file arena.h
+ * @brief Header utility file for the huge page backed arena that owns every
+ * solver buffer of a run.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+
+// Every allocation starts on a cache line boundary.
+#define ARENA_ALIGNMENT 64
+
+#define ARENA_HUGE_PAGE_SIZE (2UL * 1024UL * 1024UL)
+
+
+typedef enum
+{
+    ARENA_PAGES,
+    ARENA_TRANSPARENT_HUGE_PAGES,
+    ARENA_HUGETLB
+} ArenaBacking;
+
+typedef struct
+{
+    char* base;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+    ArenaBacking backing;
+    // The mapping as returned by mmap, which may be larger than the capacity
+    // so that base can be aligned to a huge page.
+    void* mapping;
+    size_t mappingLength;
+} Arena;
+
+
+size_t arenaSizeFor(size_t size);
+
+Arena* createArena(size_t capacity);
+
+void* arenaAlloc(Arena* arena, size_t size);
+
+void arenaReset(Arena* arena);
+
+size_t arenaPeak(const Arena* arena);
+
+const char* arenaBackingName(const Arena* arena);
+
+void freeArena(Arena* arena);
@@ -0,0 +1,251 @@
+/**
+ * @file fft.c
+ * @brief Source utility file for the self-contained FFT and the discrete sine
+ * transform used by the direct solver.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * A DST-I of length n is the imaginary part of the FFT of the odd extension
+ * 0, x[0], ..., x[n - 1], 0, -x[n - 1], ..., -x[0], of length 2 (n + 1). That
+ * FFT is purely imaginary, so two real inputs share one complex FFT: one goes
+ * in the real part and one in the imaginary part, and they come back apart in
+ * the imaginary and real parts of the result.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "fft.h"
+
+
+// Function declarations
+static size_t fftPlanArenaSize(int length);
+static int createFftPlan(FftPlan* plan, Arena* arena, int length);
+static void fft(const FftPlan* plan, double complex* data,
+    double complex* scratch);
+static void radix2(double complex* data, int length,
+    const double complex* twiddles, bool inverse);
+static int nextPowerOfTwo(int value);
+
+
+// Plain complex product. The C99 operator also handles infinities and NaNs,
+// which costs a library call per product; transforms of a grid never see them.
+static inline double complex multiply(double complex a, double complex b)
+{
+    return CMPLX((creal(a) * creal(b)) - (cimag(a) * cimag(b)),
+        (creal(a) * cimag(b)) + (cimag(a) * creal(b)));
+}
+
+
+// Function definitions
+size_t dstPlanArenaSize(int length)
+{
+    return fftPlanArenaSize(2 * (length + 1));
+}
+
+int createDstPlan(DstPlan* plan, Arena* arena, int length)
+{
+    plan->length = length;
+    return createFftPlan(&plan->fft, arena, 2 * (length + 1));
+}
+
+size_t dstScratchSize(int length)
+{
+    // The odd extension, plus the padded copy Bluestein works in.
+    int points = 2 * (length + 1);
+    size_t scratch = (size_t) points;
+    if (nextPowerOfTwo(points) != points)
+    {
+        scratch += (size_t) nextPowerOfTwo((2 * points) - 1);
+    }
+    return sizeof(double complex) * scratch;
+}
+
+void dstPair(const DstPlan* plan, double* a, double* b,
+    double complex* scratch)
+{
+    int n = plan->length;
+    int length = plan->fft.length;
+    double complex* data = scratch;
+
+    data[0] = 0.0;
+    data[n + 1] = 0.0;
+    for (int j = 0; j < n; j++)
+    {
+        double complex value = CMPLX(a[j], b != NULL ? b[j] : 0.0);
+        data[j + 1] = value;
+        data[length - 1 - j] = -value;
+    }
+
+    fft(&plan->fft, data, scratch + length);
+
+    for (int k = 0; k < n; k++)
+    {
+        a[k] = -0.5 * cimag(data[k + 1]);
+        if (b != NULL)
+        {
+            b[k] = 0.5 * creal(data[k + 1]);
+        }
+    }
+}
+
+static size_t fftPlanArenaSize(int length)
+{
+    int padded = nextPowerOfTwo(length);
+    if (padded == length)
+    {
+        return arenaSizeFor(sizeof(double complex) * (size_t) padded);
+    }
+    // Bluestein needs a power of two of at least 2 * length - 1 points.
+    padded = nextPowerOfTwo((2 * length) - 1);
+    return arenaSizeFor(sizeof(double complex) * (size_t) padded) +
+        arenaSizeFor(sizeof(double complex) * (size_t) length) +
+        arenaSizeFor(sizeof(double complex) * (size_t) padded);
+}
+
+static int createFftPlan(FftPlan* plan, Arena* arena, int length)
+{
+    plan->length = length;
+    plan->padded = nextPowerOfTwo(length);
+    plan->bluestein = (plan->padded != length);
+    if (plan->bluestein)
+    {
+        plan->padded = nextPowerOfTwo((2 * length) - 1);
+    }
+
+    int padded = plan->padded;
+    plan->twiddles = (double complex*) arenaAlloc(arena,
+        sizeof(double complex) * (size_t) padded);
+    if (plan->twiddles == NULL)
+    {
+        return -1;
+    }
+    for (int half = 1; half < padded; half <<= 1)
+    {
+        for (int k = 0; k < half; k++)
+        {
+            double angle = -M_PI * k / half;
+            plan->twiddles[half + k] = CMPLX(cos(angle), sin(angle));
+        }
+    }
+
+    plan->chirp = NULL;
+    plan->filter = NULL;
+    if (!plan->bluestein)
+    {
+        return 0;
+    }
+
+    plan->chirp = (double complex*) arenaAlloc(arena,
+        sizeof(double complex) * (size_t) length);
+    plan->filter = (double complex*) arenaAlloc(arena,
+        sizeof(double complex) * (size_t) padded);
+    if (plan->chirp == NULL || plan->filter == NULL)
+    {
+        return -1;
+    }
+
+    for (int k = 0; k < length; k++)
+    {
+        // k^2 modulo 2 * length keeps the angle small, and so accurate, for
+        // long transforms.
+        long square = ((long) k * k) % (2L * length);
+        double angle = -M_PI * (double) square / length;
+        plan->chirp[k] = CMPLX(cos(angle), sin(angle));
+    }
+
+    memset(plan->filter, 0, sizeof(double complex) * (size_t) padded);
+    plan->filter[0] = conj(plan->chirp[0]);
+    for (int k = 1; k < length; k++)
+    {
+        plan->filter[k] = conj(plan->chirp[k]);
+        plan->filter[padded - k] = conj(plan->chirp[k]);
+    }
+    radix2(plan->filter, padded, plan->twiddles, false);
+    return 0;
+}
+
+// Forward transform in place. Bluestein plans need plan->padded points of
+// scratch.
+static void fft(const FftPlan* plan, double complex* data,
+    double complex* scratch)
+{
+    if (!plan->bluestein)
+    {
+        radix2(data, plan->length, plan->twiddles, false);
+        return;
+    }
+
+    int length = plan->length;
+    int padded = plan->padded;
+    for (int k = 0; k < length; k++)
+    {
+        scratch[k] = multiply(data[k], plan->chirp[k]);
+    }
+    for (int k = length; k < padded; k++)
+    {
+        scratch[k] = 0.0;
+    }
+
+    radix2(scratch, padded, plan->twiddles, false);
+    for (int k = 0; k < padded; k++)
+    {
+        scratch[k] = multiply(scratch[k], plan->filter[k]);
+    }
+    radix2(scratch, padded, plan->twiddles, true);
+
+    for (int k = 0; k < length; k++)
+    {
+        data[k] = multiply(plan->chirp[k], scratch[k]) / padded;
+    }
+}
+
+// Iterative radix-2 FFT of a power of two length. The inverse is unscaled.
+// twiddles is laid out as in FftPlan.
+static void radix2(double complex* data, int length,
+    const double complex* twiddles, bool inverse)
+{
+    // Bit reversal permutation.
+    for (int i = 1, j = 0; i < length; i++)
+    {
+        int bit = length >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            double complex swap = data[i];
+            data[i] = data[j];
+            data[j] = swap;
+        }
+    }
+
+    for (int span = 2; span <= length; span <<= 1)
+    {
+        int half = span / 2;
+        const double complex* stage = twiddles + half;
+        for (int start = 0; start < length; start += span)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                double complex twiddle = inverse ? conj(stage[k]) : stage[k];
+                double complex odd = multiply(data[start + k + half],
+                    twiddle);
+                data[start + k + half] = data[start + k] - odd;
+                data[start + k] += odd;
+            }
+        }
+    }
+}
+
+static int nextPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+    return power;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file fft.h
+ * @brief Header utility file for the self-contained FFT and the discrete sine
+ * transform used by the direct solver.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <complex.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+
+// Complex FFT of any length: radix-2 for powers of two, Bluestein's chirp-z
+// algorithm (through a power of two FFT) otherwise. Plans are read-only once
+// created, so threads may share one, each with its own scratch space.
+typedef struct
+{
+    int length;
+    // Power of two the transform is carried out at.
+    int padded;
+    bool bluestein;
+    // exp(-2 pi i k / span) for k below span / 2, at twiddles[span / 2 + k],
+    // for every span of the radix-2 stages, so each stage reads them in order.
+    double complex* twiddles;
+    // Bluestein only: exp(-pi i k^2 / length), and the FFT of its conjugate
+    // wrapped around to padded points.
+    double complex* chirp;
+    double complex* filter;
+} FftPlan;
+
+// DST-I of length n: y[k] = sum over j of x[j] sin(pi (j + 1) (k + 1) / (n + 1)).
+// Applying it twice multiplies by (n + 1) / 2.
+typedef struct
+{
+    int length;
+    FftPlan fft;
+} DstPlan;
+
+
+size_t dstPlanArenaSize(int length);
+
+int createDstPlan(DstPlan* plan, Arena* arena, int length);
+
+// Bytes of scratch space one thread needs to run a transform of the length.
+size_t dstScratchSize(int length);
+
+// Transforms a and b in place, with one complex FFT for the pair. b may be
+// NULL.
+void dstPair(const DstPlan* plan, double* a, double* b,
+    double complex* scratch);
@@ -0,0 +1,136 @@
+/**
+ * @file matrix.c
+ * @brief Source utility file to manage creation and destruction of arrays used.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Every solver stores the grid as one contiguous row-major array, so MPI can
+ * send rows directly and callers of the library can read the result without a
+ * copy. A multi-field solve interleaves its fields within each cell of that
+ * array, so one pass over memory relaxes them all.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+
+
+size_t doubleMatrixArenaSize(const GridExtents* extents)
+{
+    return fieldsMatrixArenaSize(extents, 1);
+}
+
+size_t fieldsMatrixArenaSize(const GridExtents* extents, int fields)
+{
+    return arenaSizeFor(sizeof(double) * gridCells(extents) *
+        (unsigned long) fields);
+}
+
+// The grid is only allocated here, not written. It is filled in by
+// initDoubleMatrixRows, which should be called by the thread that will work on
+// those rows, so the pages are first touched (and therefore placed) on the
+// NUMA node of that thread. Returns NULL if the arena is exhausted.
+double* createDoubleMatrix(Arena* arena, const GridExtents* extents)
+{
+    return createFieldsMatrix(arena, extents, 1);
+}
+
+// As createDoubleMatrix, for a grid holding fields values per cell, interleaved
+// (see initFieldsMatrixRows).
+double* createFieldsMatrix(Arena* arena, const GridExtents* extents,
+    int fields)
+{
+    return (double*) arenaAlloc(arena, sizeof(double) * gridCells(extents) *
+        (unsigned long) fields);
+}
+
+// Initial value of column ii of row x of plane z. By default the top row and
+// left column are 1.0 and the bottom row, right column and, in 3D, the front
+// and back planes are 0.0. The edges of each plane take precedence over the
+// front and back planes. The interior is 0.0.
+static double initialValue(const GridExtents* extents, int x, int z, int ii,
+    const RelaxBoundaries* boundaries)
+{
+    if (x == 0)
+    {
+        return boundaries->top;
+    }
+    if (ii == 0)
+    {
+        return boundaries->left;
+    }
+    if (x == (extents->rows - 1))
+    {
+        return boundaries->bottom;
+    }
+    if (ii == (extents->columns - 1))
+    {
+        return boundaries->right;
+    }
+    if (extents->planes > 1 && z == 0)
+    {
+        return boundaries->front;
+    }
+    if (extents->planes > 1 && z == (extents->planes - 1))
+    {
+        return boundaries->back;
+    }
+    return 0.0;
+}
+
+// Initialise rows [firstRow, lastRow) of the stack of rows (see GridExtents)
+// with the boundary conditions, and the interior with 0.0. rows points at the
+// storage of firstRow, so a slab holding only part of the grid can be
+// initialised too.
+void initDoubleMatrixRows(double* rows, const GridExtents* extents,
+    int firstRow, int lastRow, const RelaxBoundaries* boundaries)
+{
+    initFieldsMatrixRows(rows, extents, firstRow, lastRow, boundaries, 1);
+}
+
+// As initDoubleMatrixRows, for fields copies of the grid interleaved per cell:
+// field f of a cell holds its value under boundaries[f], and comes f values
+// after the cell's first. A row is therefore columns * fields values long.
+void initFieldsMatrixRows(double* rows, const GridExtents* extents,
+    int firstRow, int lastRow, const RelaxBoundaries* boundaries, int fields)
+{
+    int columns = extents->columns;
+    unsigned long rowLength = (unsigned long) columns * (unsigned long) fields;
+
+    for (int i = firstRow; i < lastRow; i++)
+    {
+        double* row = rows + ((unsigned long) (i - firstRow) * rowLength);
+        int x = i % extents->rows;
+        int z = i / extents->rows;
+        for (int ii = 0; ii < columns; ii++)
+        {
+            for (int f = 0; f < fields; f++)
+            {
+                row[((long) ii * fields) + f] = initialValue(extents, x, z, ii,
+                    &boundaries[f]);
+            }
+        }
+    }
+}
+
+// Prints each plane in turn, separated by a blank line.
+void printDoubleMatrix(const double* matrix, int rows, int columns, int planes)
+{
+    for (int z = 0; z < planes; z++)
+    {
+        if (z > 0)
+        {
+            printf("\n");
+        }
+        for(int i = 0; i < rows; i++)
+        {
+            for(int ii = 0; ii < columns; ii++)
+            {
+                printf(" %f ", matrix[((((long) z * rows) + i) * columns) +
+                    ii]);
+            }
+            printf("\n");
+        }
+    }
+}
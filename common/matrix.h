@@ -0,0 +1,50 @@
+/**
+ * @file matrix.h
+ * @brief Header utility file to manage creation and destruction of arrays used.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include "arena.h"
+#include "relax.h"
+
+
+// Size of a grid: rows x columns, or a volume of planes of rows x columns when
+// planes is above 1. Volumes are stored plane by plane, each row-major, so the
+// grid is always a stack of rows * planes contiguous rows. Row r of that stack
+// is row r % rows of plane r / rows.
+typedef struct
+{
+    int rows;
+    int columns;
+    int planes;
+} GridExtents;
+
+
+static inline unsigned long gridCells(const GridExtents* extents)
+{
+    return (unsigned long) extents->rows * (unsigned long) extents->columns *
+        (unsigned long) extents->planes;
+}
+
+size_t doubleMatrixArenaSize(const GridExtents* extents);
+
+size_t fieldsMatrixArenaSize(const GridExtents* extents, int fields);
+
+double* createDoubleMatrix(Arena* arena, const GridExtents* extents);
+
+double* createFieldsMatrix(Arena* arena, const GridExtents* extents,
+    int fields);
+
+void initDoubleMatrixRows(double* rows, const GridExtents* extents,
+    int firstRow, int lastRow, const RelaxBoundaries* boundaries);
+
+void initFieldsMatrixRows(double* rows, const GridExtents* extents,
+    int firstRow, int lastRow, const RelaxBoundaries* boundaries, int fields);
+
+void printDoubleMatrix(const double* matrix, int rows, int columns,
+    int planes);
@@ -0,0 +1,612 @@
+/**
+ * @file relax.c
+ * @brief Source file for the librelax API: solver configuration, buffers and
+ * dispatch to the solve methods.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+RelaxSolver* relaxCreate(void)
+{
+    RelaxSolver* solver = (RelaxSolver*) calloc(1, sizeof(RelaxSolver));
+    if (solver == NULL)
+    {
+        return NULL;
+    }
+
+    // Defaults match the command line programs.
+    solver->extents.rows = 4;
+    solver->extents.columns = 4;
+    solver->extents.planes = 1;
+    solver->precision = 0.001;
+    solver->workers = 1;
+    solver->method = RELAX_METHOD_THREADS;
+    solver->affinity.policy = AFFINITY_NONE;
+    solver->boundaries.top = 1.0;
+    solver->boundaries.left = 1.0;
+    solver->boundaries.bottom = 0.0;
+    solver->boundaries.right = 0.0;
+    solver->boundaries.front = 0.0;
+    solver->boundaries.back = 0.0;
+    solver->stencil = RELAX_STENCIL_5_POINT;
+    solver->weights = stencilWeights(1.0, 1.0);
+    solver->tileSize = 0;
+    solver->wakeFraction = 0.1;
+    solver->sweepsPerPass = 4;
+    solver->status = RELAX_ERROR;
+    atomic_init(&solver->cancelled, 0);
+
+    return solver;
+}
+
+void relaxDestroy(RelaxSolver* solver)
+{
+    if (solver == NULL)
+    {
+        return;
+    }
+    closeGridStore(solver);
+    freeArena(solver->arena);
+    freeAffinity(&solver->affinity);
+    free(solver->storePath);
+    free(solver->telemetryPath);
+    free(solver->fieldBoundaries);
+    free(solver);
+}
+
+int relaxSetDimension(RelaxSolver* solver, int dimension)
+{
+    return relaxSetExtents(solver, dimension, dimension, 1);
+}
+
+int relaxSetExtents(RelaxSolver* solver, int rows, int columns, int planes)
+{
+    if (rows < 3 || columns < 3 || planes < 1 || planes == 2)
+    {
+        return RELAX_ERROR;
+    }
+    solver->extents.rows = rows;
+    solver->extents.columns = columns;
+    solver->extents.planes = planes;
+    return RELAX_OK;
+}
+
+int relaxSetPrecision(RelaxSolver* solver, double precision)
+{
+    if (precision < 0.0 || precision > 1.0)
+    {
+        return RELAX_ERROR;
+    }
+    solver->precision = precision;
+    return RELAX_OK;
+}
+
+int relaxSetWorkers(RelaxSolver* solver, int workers)
+{
+    if (workers < 1)
+    {
+        return RELAX_ERROR;
+    }
+    solver->workers = workers;
+    return RELAX_OK;
+}
+
+int relaxSetMethod(RelaxSolver* solver, RelaxMethod method)
+{
+    if (method != RELAX_METHOD_THREADS && method != RELAX_METHOD_JACOBI &&
+        method != RELAX_METHOD_WAVEFRONT &&
+        method != RELAX_METHOD_OUT_OF_CORE && method != RELAX_METHOD_DIRECT &&
+        method != RELAX_METHOD_CHEBYSHEV)
+    {
+        return RELAX_ERROR;
+    }
+    solver->method = method;
+    return RELAX_OK;
+}
+
+int relaxSetMethodByName(RelaxSolver* solver, const char* name)
+{
+    // The name also sets how the Chebyshev method finds its spectral bound.
+    if (strncmp(name, "chebyshev", 9) == 0)
+    {
+        if (strcmp(name, "chebyshev") != 0 &&
+            strcmp(name, "chebyshev:adaptive") != 0)
+        {
+            return RELAX_ERROR;
+        }
+        solver->chebyshevAdaptive = (name[9] != '\0');
+        return relaxSetMethod(solver, RELAX_METHOD_CHEBYSHEV);
+    }
+
+    RelaxMethod methods[] = { RELAX_METHOD_THREADS, RELAX_METHOD_JACOBI,
+        RELAX_METHOD_WAVEFRONT, RELAX_METHOD_OUT_OF_CORE, RELAX_METHOD_DIRECT,
+        RELAX_METHOD_CHEBYSHEV };
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+    {
+        if (strcmp(name, relaxMethodName(methods[i])) == 0)
+        {
+            return relaxSetMethod(solver, methods[i]);
+        }
+    }
+    return RELAX_ERROR;
+}
+
+int relaxSetChebyshevAdaptive(RelaxSolver* solver, int adaptive)
+{
+    solver->chebyshevAdaptive = (adaptive != 0);
+    return RELAX_OK;
+}
+
+// Accepts "none", "compact", "scatter" or a CPU list such as "0,2,4-7".
+int relaxSetAffinity(RelaxSolver* solver, const char* spec)
+{
+    Affinity affinity;
+    if (parseAffinity(&affinity, spec) != 0)
+    {
+        return RELAX_ERROR;
+    }
+    freeAffinity(&solver->affinity);
+    solver->affinity = affinity;
+    return RELAX_OK;
+}
+
+int relaxSetBoundaries(RelaxSolver* solver, const RelaxBoundaries* boundaries)
+{
+    solver->boundaries = *boundaries;
+    return RELAX_OK;
+}
+
+// The generic multi-field kernels keep the changes of every field in a local
+// array of STENCIL_MAX_FIELDS.
+_Static_assert(RELAX_MAX_FIELDS <= STENCIL_MAX_FIELDS,
+    "more fields than the multi-field kernels hold");
+
+int relaxSetFields(RelaxSolver* solver, const RelaxBoundaries* boundaries,
+    int count)
+{
+    if (count < 0 || count > RELAX_MAX_FIELDS ||
+        (count > 0 && boundaries == NULL))
+    {
+        return RELAX_ERROR;
+    }
+    RelaxBoundaries* copy = NULL;
+    if (count > 0)
+    {
+        copy = (RelaxBoundaries*) malloc(sizeof(RelaxBoundaries) *
+            (size_t) count);
+        if (copy == NULL)
+        {
+            return RELAX_ERROR;
+        }
+        memcpy(copy, boundaries, sizeof(RelaxBoundaries) * (size_t) count);
+    }
+    free(solver->fieldBoundaries);
+    solver->fieldBoundaries = copy;
+    solver->fieldCount = count;
+    return RELAX_OK;
+}
+
+int relaxSetInitialGuess(RelaxSolver* solver, const double* grid)
+{
+    solver->initialGuess = grid;
+    return RELAX_OK;
+}
+
+int relaxParseBoundaries(const char* spec, RelaxBoundaries* boundaries)
+{
+    RelaxBoundaries parsed = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    char extra;
+    int count = sscanf(spec, "%lf,%lf,%lf,%lf,%lf,%lf%c", &parsed.top,
+        &parsed.left, &parsed.bottom, &parsed.right, &parsed.front,
+        &parsed.back, &extra);
+    if (count != 4 && count != 6)
+    {
+        return RELAX_ERROR;
+    }
+    *boundaries = parsed;
+    return RELAX_OK;
+}
+
+int relaxSetStencil(RelaxSolver* solver, RelaxStencil stencil,
+    double verticalWeight, double horizontalWeight)
+{
+    if (stencil != RELAX_STENCIL_5_POINT && stencil != RELAX_STENCIL_9_POINT &&
+        stencil != RELAX_STENCIL_WEIGHTED)
+    {
+        return RELAX_ERROR;
+    }
+    if (stencil == RELAX_STENCIL_WEIGHTED &&
+        !(verticalWeight > 0.0 && horizontalWeight > 0.0))
+    {
+        return RELAX_ERROR;
+    }
+    solver->stencil = stencil;
+    if (stencil == RELAX_STENCIL_WEIGHTED)
+    {
+        solver->weights = stencilWeights(verticalWeight, horizontalWeight);
+    }
+    return RELAX_OK;
+}
+
+int relaxSetStencilByName(RelaxSolver* solver, const char* spec)
+{
+    if (strcmp(spec, "5") == 0)
+    {
+        return relaxSetStencil(solver, RELAX_STENCIL_5_POINT, 1.0, 1.0);
+    }
+    if (strcmp(spec, "9") == 0)
+    {
+        return relaxSetStencil(solver, RELAX_STENCIL_9_POINT, 1.0, 1.0);
+    }
+
+    double verticalWeight, horizontalWeight;
+    char extra;
+    if (sscanf(spec, "weighted:%lf,%lf%c", &verticalWeight, &horizontalWeight,
+        &extra) == 2)
+    {
+        return relaxSetStencil(solver, RELAX_STENCIL_WEIGHTED, verticalWeight,
+            horizontalWeight);
+    }
+    return RELAX_ERROR;
+}
+
+int relaxSetTiling(RelaxSolver* solver, int tileSize, double wakeFraction)
+{
+    if (tileSize < 0 || wakeFraction < 0.0 || wakeFraction > 1.0)
+    {
+        return RELAX_ERROR;
+    }
+    solver->tileSize = tileSize;
+    solver->wakeFraction = wakeFraction;
+    return RELAX_OK;
+}
+
+int relaxSetOutOfCore(RelaxSolver* solver, const char* path,
+    int sweepsPerPass)
+{
+    if (path == NULL || sweepsPerPass < 1 || sweepsPerPass > 64)
+    {
+        return RELAX_ERROR;
+    }
+    char* copy = strdup(path);
+    if (copy == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    free(solver->storePath);
+    solver->storePath = copy;
+    solver->sweepsPerPass = sweepsPerPass;
+    return RELAX_OK;
+}
+
+void relaxSetProgressCallback(RelaxSolver* solver,
+    RelaxProgressCallback callback, void* userData)
+{
+    solver->progress = callback;
+    solver->progressData = userData;
+}
+
+int relaxSetTelemetry(RelaxSolver* solver, const char* destination)
+{
+    char* copy = NULL;
+    if (destination != NULL)
+    {
+        copy = strdup(destination);
+        if (copy == NULL)
+        {
+            return RELAX_ERROR;
+        }
+    }
+    free(solver->telemetryPath);
+    solver->telemetryPath = copy;
+    return RELAX_OK;
+}
+
+// Runs the solve of the configured method.
+static int solveMethod(RelaxSolver* solver)
+{
+    atomic_store(&solver->cancelled, 0);
+    solver->iterations = 0;
+    solver->chebyshevConverged = false;
+
+    // Only the Jacobi sweeps relax several fields at once.
+    if (solver->fieldCount > 0 && solver->method != RELAX_METHOD_JACOBI)
+    {
+        return RELAX_ERROR;
+    }
+
+    int status = RELAX_ERROR;
+    switch (solver->method)
+    {
+        case RELAX_METHOD_THREADS:
+            beginTelemetry(solver);
+            status = solveThreads(solver);
+            break;
+        case RELAX_METHOD_JACOBI:
+            beginTelemetry(solver);
+            status = (solver->fieldCount > 0) ? solveFields(solver) :
+                solveJacobi(solver);
+            break;
+        case RELAX_METHOD_WAVEFRONT:
+            beginTelemetry(solver);
+            status = solveWavefront(solver);
+            break;
+        case RELAX_METHOD_OUT_OF_CORE:
+            beginTelemetry(solver);
+            status = solveOutOfCore(solver);
+            break;
+        case RELAX_METHOD_CHEBYSHEV:
+            beginTelemetry(solver);
+            status = solveChebyshev(solver);
+            break;
+        case RELAX_METHOD_DIRECT:
+            // There are no sweeps to report.
+            return solveDirect(solver);
+    }
+    endTelemetry(solver);
+    return status;
+}
+
+int relaxSolve(RelaxSolver* solver)
+{
+    solver->status = solveMethod(solver);
+    return solver->status;
+}
+
+const double* relaxGetResult(const RelaxSolver* solver, int* dimension)
+{
+    if (dimension != NULL)
+    {
+        *dimension = solver->extents.columns;
+    }
+    return solver->grid;
+}
+
+void relaxGetExtents(const RelaxSolver* solver, int* rows, int* columns,
+    int* planes)
+{
+    *rows = solver->extents.rows;
+    *columns = solver->extents.columns;
+    *planes = solver->extents.planes;
+}
+
+int relaxGetStatus(const RelaxSolver* solver)
+{
+    return solver->status;
+}
+
+int relaxGetIterations(const RelaxSolver* solver)
+{
+    return solver->iterations;
+}
+
+const double* relaxGetFieldResult(const RelaxSolver* solver, int field)
+{
+    if (solver->grid == NULL || field < 0 || field >= solver->resultFields)
+    {
+        return NULL;
+    }
+    return solver->grid + ((unsigned long) field *
+        gridCells(&solver->extents));
+}
+
+int relaxGetFieldIterations(const RelaxSolver* solver, int field)
+{
+    if (field < 0 || field >= solver->resultFields)
+    {
+        return 0;
+    }
+    if (solver->fieldIterations == NULL)
+    {
+        return solver->iterations;
+    }
+    return solver->fieldIterations[field];
+}
+
+int relaxGetJacobiEstimate(const RelaxSolver* solver)
+{
+    if (!solver->chebyshevConverged)
+    {
+        return 0;
+    }
+    return countJacobiSweeps(solver, solver->chebyshevFromGuess);
+}
+
+size_t relaxGetFootprint(const RelaxSolver* solver)
+{
+    return solver->arena != NULL ? arenaPeak(solver->arena) : 0;
+}
+
+const char* relaxGetMemoryBacking(const RelaxSolver* solver)
+{
+    if (solver->storeMapping != NULL)
+    {
+        return "file mapping";
+    }
+    return solver->arena != NULL ? arenaBackingName(solver->arena) : "none";
+}
+
+const char* relaxGetAffinityName(const RelaxSolver* solver)
+{
+    return affinityPolicyName(solver->affinity.policy);
+}
+
+// Reports where a worker of the last solve ran and which rows it initialised.
+// cpu is -1 if the worker was not pinned. The distributed solver reports a
+// single placement, for the calling rank.
+int relaxGetWorkerPlacement(const RelaxSolver* solver, int worker, int* cpu,
+    int* firstRow, int* lastRow)
+{
+    if (solver->placements == NULL || worker < 0 ||
+        worker >= solver->placementCount)
+    {
+        return RELAX_ERROR;
+    }
+    *cpu = solver->placements[worker].cpu;
+    *firstRow = solver->placements[worker].firstRow;
+    *lastRow = solver->placements[worker].lastRow;
+    return RELAX_OK;
+}
+
+const char* relaxMethodName(RelaxMethod method)
+{
+    switch (method)
+    {
+        case RELAX_METHOD_THREADS:
+            return "threads";
+        case RELAX_METHOD_JACOBI:
+            return "jacobi";
+        case RELAX_METHOD_WAVEFRONT:
+            return "wavefront";
+        case RELAX_METHOD_OUT_OF_CORE:
+            return "outofcore";
+        case RELAX_METHOD_DIRECT:
+            return "direct";
+        case RELAX_METHOD_CHEBYSHEV:
+            return "chebyshev";
+    }
+    return "unknown";
+}
+
+const char* relaxStencilName(RelaxStencil stencil)
+{
+    switch (stencil)
+    {
+        case RELAX_STENCIL_5_POINT:
+            return "5-point";
+        case RELAX_STENCIL_9_POINT:
+            return "9-point";
+        case RELAX_STENCIL_WEIGHTED:
+            return "weighted";
+    }
+    return "unknown";
+}
+
+// Empties the arena of the previous solve, or replaces it if it is smaller
+// than the given size. The method then allocates the grid and its other
+// buffers from it. Reusing the arena keeps repeated solves of the same size
+// (e.g. in a batch) free of mmap calls and page faults.
+int prepareSolve(RelaxSolver* solver, size_t arenaBytes)
+{
+    closeGridStore(solver);
+    solver->grid = NULL;
+    solver->resultFields = 1;
+    solver->fieldIterations = NULL;
+    solver->placements = NULL;
+    solver->placementCount = 0;
+
+    if (solver->arena != NULL && solver->arena->capacity >= arenaBytes)
+    {
+        arenaReset(solver->arena);
+        return RELAX_OK;
+    }
+
+    freeArena(solver->arena);
+    solver->arena = createArena(arenaBytes);
+    if (solver->arena == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    return RELAX_OK;
+}
+
+// Allocates a buffer for the current solve. Buffers must be accounted for in
+// the size given to prepareSolve.
+void* solverAlloc(RelaxSolver* solver, size_t size)
+{
+    void* pointer = arenaAlloc(solver->arena, size);
+    if (pointer == NULL)
+    {
+        fprintf(stderr, "Arena exhausted allocating %zu bytes.\n", size);
+    }
+    return pointer;
+}
+
+// Initialises rows [firstRow, lastRow) of the stacked planes of the grid (see
+// initDoubleMatrixRows), where rows points at firstRow, and then copies the
+// interior cells of those rows from the initial guess, if there is one.
+void initSolverRows(const RelaxSolver* solver, double* rows, int firstRow,
+    int lastRow)
+{
+    const GridExtents* extents = &solver->extents;
+    initDoubleMatrixRows(rows, extents, firstRow, lastRow,
+        &solver->boundaries);
+    if (solver->initialGuess == NULL)
+    {
+        return;
+    }
+
+    int columns = extents->columns;
+    for (int i = firstRow; i < lastRow; i++)
+    {
+        int x = i % extents->rows;
+        int z = i / extents->rows;
+        if (x == 0 || x == extents->rows - 1 ||
+            (extents->planes > 1 && (z == 0 || z == extents->planes - 1)))
+        {
+            continue;
+        }
+        memcpy(rows + ((long) (i - firstRow) * columns) + 1,
+            solver->initialGuess + ((long) i * columns) + 1,
+            sizeof(double) * (size_t) (columns - 2));
+    }
+}
+
+// Passes progress to the telemetry stream and the callback, if any. Returns
+// non-zero if the solve should stop, and records that for the other workers.
+int reportProgress(RelaxSolver* solver, int iteration, double maxChange,
+    double skew)
+{
+    if (solver->telemetry != NULL)
+    {
+        recordTelemetry(solver->telemetry, iteration, maxChange, skew);
+    }
+    if (solver->progress == NULL)
+    {
+        return 0;
+    }
+
+    RelaxProgress progress;
+    progress.iteration = iteration;
+    progress.maxChange = maxChange;
+    progress.skew = skew;
+    if (solver->progress(&progress, solver->progressData) != 0)
+    {
+        atomic_store(&solver->cancelled, 1);
+        return 1;
+    }
+    return 0;
+}
+
+// Starts the telemetry stream for a solve, if one is set. The solve goes ahead
+// without it if the destination cannot be opened.
+void beginTelemetry(RelaxSolver* solver)
+{
+    solver->telemetry = NULL;
+    if (solver->telemetryPath == NULL)
+    {
+        return;
+    }
+
+    char header[128];
+    snprintf(header, sizeof(header), "%s %dx%dx%d, %s stencil, precision %g",
+        relaxMethodName(solver->method), solver->extents.rows,
+        solver->extents.columns, solver->extents.planes,
+        relaxStencilName(solver->stencil), solver->precision);
+    solver->telemetry = startTelemetry(solver->telemetryPath, header,
+        solver->precision);
+}
+
+void endTelemetry(RelaxSolver* solver)
+{
+    stopTelemetry(solver->telemetry);
+    solver->telemetry = NULL;
+}
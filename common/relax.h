@@ -0,0 +1,261 @@
+/**
+ * @file relax.h
+ * @brief Public C API of librelax, the solver core shared by the command line
+ * programs.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Typical use:
+ *
+ *     RelaxSolver* solver = relaxCreate();
+ *     relaxSetExtents(solver, 1000, 4000, 1);
+ *     relaxSetPrecision(solver, 0.001);
+ *     relaxSetWorkers(solver, 8);
+ *     if (relaxSolve(solver) == RELAX_OK)
+ *     {
+ *         int columns;
+ *         const double* grid = relaxGetResult(solver, &columns);
+ *         // grid[(row * columns) + column]
+ *     }
+ *     relaxDestroy(solver);
+ *
+ * Setters return RELAX_OK, or RELAX_ERROR if the value is out of range (the
+ * previous value is kept). A solver is not thread safe, but separate solvers
+ * may be used from separate threads.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+
+typedef struct RelaxSolver RelaxSolver;
+
+// A persistent set of worker threads for solving batches of independent grids.
+typedef struct RelaxPool RelaxPool;
+
+typedef enum
+{
+    RELAX_OK = 0,
+    RELAX_ERROR = -1,
+    // The progress callback asked for the solve to stop.
+    RELAX_CANCELLED = 1
+} RelaxStatus;
+
+typedef enum
+{
+    // In-place relaxation by racing pthreads, with a mutex per row.
+    RELAX_METHOD_THREADS,
+    // Single threaded Jacobi sweeps. This is the reference answer.
+    RELAX_METHOD_JACOBI,
+    // Pipelined in-place relaxation: each thread runs its own sweep a few rows
+    // behind the previous thread's, so sweeps overlap without locks. Results
+    // are reproducible run to run.
+    RELAX_METHOD_WAVEFRONT,
+    // Single threaded in-place relaxation of a grid kept in a memory-mapped
+    // file (see relaxSetOutOfCore), for grids larger than memory.
+    RELAX_METHOD_OUT_OF_CORE,
+    // Exact solve with discrete sine transforms rather than sweeps, split over
+    // the workers. 2D only; the precision does not apply and the progress
+    // callback is not called.
+    RELAX_METHOD_DIRECT,
+    // Jacobi sweeps accelerated by Chebyshev semi-iteration, split over the
+    // workers without locks. Needs roughly the square root of the sweeps of
+    // plain Jacobi. Not tiled.
+    RELAX_METHOD_CHEBYSHEV
+} RelaxMethod;
+
+typedef enum
+{
+    // Average of the nearest neighbours: four in 2D and six in 3D, where it is
+    // the 7-point stencil.
+    RELAX_STENCIL_5_POINT,
+    // Compact 9-point Laplacian: edge neighbours weigh 4, corners weigh 1. 2D
+    // only.
+    RELAX_STENCIL_9_POINT,
+    // Vertical and horizontal neighbour pairs weighted separately, for
+    // anisotropic problems. 2D only.
+    RELAX_STENCIL_WEIGHTED
+} RelaxStencil;
+
+// Fixed values of the four edges of the grid. The top corners belong to the
+// top row, the bottom left corner to the left column and the bottom right
+// corner to the bottom row. In 3D these are the faces around each plane, and
+// front and back are the first and last planes, inside those edges.
+typedef struct
+{
+    double top;
+    double left;
+    double bottom;
+    double right;
+    double front;
+    double back;
+} RelaxBoundaries;
+
+typedef struct
+{
+    // Number of completed sweeps.
+    int iteration;
+    // Largest change of a cell during the last sweep.
+    double maxChange;
+    // Spread between the workers: for the distributed solver, the seconds
+    // between the fastest and the slowest rank relaxing its slab this sweep;
+    // for the threaded method, the sweeps between the furthest ahead and the
+    // furthest behind worker. 0 for the other methods.
+    double skew;
+} RelaxProgress;
+
+// Called after each sweep (by worker 0 for the threaded method, by the worker
+// that ran the sweep, in sweep order, for the wavefront method, and by rank 0
+// for the distributed solver). Return non-zero to cancel the solve.
+typedef int (*RelaxProgressCallback)(const RelaxProgress* progress,
+    void* userData);
+
+
+RelaxSolver* relaxCreate(void);
+
+void relaxDestroy(RelaxSolver* solver);
+
+// Sets a square dimension x dimension grid.
+int relaxSetDimension(RelaxSolver* solver, int dimension);
+
+// Sets a rows x columns grid, or with planes above 1 a volume of planes such
+// grids. rows and columns must be at least 3, and planes 1 or at least 3.
+// Volumes are relaxed with the 7-point stencil and are not tiled.
+int relaxSetExtents(RelaxSolver* solver, int rows, int columns, int planes);
+
+int relaxSetPrecision(RelaxSolver* solver, double precision);
+
+int relaxSetWorkers(RelaxSolver* solver, int workers);
+
+int relaxSetMethod(RelaxSolver* solver, RelaxMethod method);
+
+// Accepts the names given by relaxMethodName, and "chebyshev:adaptive" for the
+// Chebyshev method with an adaptive spectral bound.
+int relaxSetMethodByName(RelaxSolver* solver, const char* name);
+
+// By default the Chebyshev method computes the spectral radius of the Jacobi
+// sweep from the grid dimensions and the stencil. Adaptively, it starts from
+// plain Jacobi and raises its estimate from the observed convergence rate,
+// which also covers problems the formula does not.
+int relaxSetChebyshevAdaptive(RelaxSolver* solver, int adaptive);
+
+int relaxSetAffinity(RelaxSolver* solver, const char* spec);
+
+int relaxSetBoundaries(RelaxSolver* solver, const RelaxBoundaries* boundaries);
+
+// Solves the grid under count boundary configurations at once, as count
+// fields interleaved per cell, instead of under the single one set with
+// relaxSetBoundaries. Each field stops on its own convergence, and its result
+// is exactly that of a solve with its boundaries alone. Only
+// RELAX_METHOD_JACOBI (and the distributed Jacobi sweeps) solve several
+// fields; relaxSolve returns RELAX_ERROR for the other methods. A count of 0
+// goes back to the single grid, and at most RELAX_MAX_FIELDS are taken.
+#define RELAX_MAX_FIELDS 64
+int relaxSetFields(RelaxSolver* solver, const RelaxBoundaries* boundaries,
+    int count);
+
+// Starts the next solves from grid, which holds a cell per grid cell in the
+// layout relaxGetResult uses (e.g. the result of an earlier solve of a grid of
+// the same extents), instead of from zero. Only the interior is read; the
+// boundaries still come from relaxSetBoundaries. grid is not copied and must
+// stay valid until the guess is cleared with NULL. A guess close to the answer
+// needs fewer sweeps. The relaxing shared memory methods start from the guess;
+// RELAX_METHOD_DIRECT, multi-field and distributed solves ignore it.
+int relaxSetInitialGuess(RelaxSolver* solver, const double* grid);
+
+// Accepts "TOP,LEFT,BOTTOM,RIGHT" or "TOP,LEFT,BOTTOM,RIGHT,FRONT,BACK", e.g.
+// "1,1,0,0". Front and back default to 0.
+int relaxParseBoundaries(const char* spec, RelaxBoundaries* boundaries);
+
+// The weights only apply to RELAX_STENCIL_WEIGHTED and must be positive. They
+// are relative: 1, 1 is the 5-point average. Applies to every method.
+int relaxSetStencil(RelaxSolver* solver, RelaxStencil stencil,
+    double verticalWeight, double horizontalWeight);
+
+// Accepts "5", "9" or "weighted:VERTICAL,HORIZONTAL", e.g. "weighted:1,4".
+int relaxSetStencilByName(RelaxSolver* solver, const char* spec);
+
+// Splits the grid into tileSize x tileSize tiles and skips a tile while it and
+// its neighbours changed by less than wakeFraction * precision in the last
+// sweep. A full sweep confirms convergence before the solve finishes. A
+// tileSize of 0 (the default) sweeps every cell every time. Applies to 2D grids
+// with the threaded and Jacobi methods.
+int relaxSetTiling(RelaxSolver* solver, int tileSize, double wakeFraction);
+
+// Sets the file that RELAX_METHOD_OUT_OF_CORE keeps the grid in. The file is
+// created or overwritten, and holds the result afterwards as raw doubles in the
+// layout relaxGetResult uses. Each pass over the file runs sweepsPerPass
+// sweeps, so the file is read that many times less often; the solve may then
+// run up to sweepsPerPass - 1 sweeps past convergence.
+int relaxSetOutOfCore(RelaxSolver* solver, const char* path,
+    int sweepsPerPass);
+
+void relaxSetProgressCallback(RelaxSolver* solver,
+    RelaxProgressCallback callback, void* userData);
+
+// Streams the progress of every sweep (residual, sweep time, skew and an
+// estimate of the time left) as lines of text to destination: a file, created
+// or overwritten, or "unix:PATH" for a listening Unix stream socket. A
+// background thread does the writing, so the solve never waits for it. If the
+// destination cannot be opened, the solve goes ahead without it. NULL turns
+// the stream off. Not used by RELAX_METHOD_DIRECT.
+int relaxSetTelemetry(RelaxSolver* solver, const char* destination);
+
+int relaxSolve(RelaxSolver* solver);
+
+// Zero-copy access to the last result, row-major and contiguous, plane after
+// plane for volumes. dimension, if not NULL, receives the number of columns
+// (the length of a row). The pointer stays valid until the next solve or
+// relaxDestroy.
+const double* relaxGetResult(const RelaxSolver* solver, int* dimension);
+
+void relaxGetExtents(const RelaxSolver* solver, int* rows, int* columns,
+    int* planes);
+
+// What the last relaxSolve returned, which is how the solves of a batch are
+// told apart. RELAX_ERROR before the first solve.
+int relaxGetStatus(const RelaxSolver* solver);
+
+int relaxGetIterations(const RelaxSolver* solver);
+
+// The result of one field of the last solve, laid out as relaxGetResult (which
+// returns field 0), or NULL if there is no such field. A solve without fields
+// has the one field 0.
+const double* relaxGetFieldResult(const RelaxSolver* solver, int field);
+
+// Sweeps after which a field of the last solve converged. The solve ran as
+// many sweeps as its slowest field.
+int relaxGetFieldIterations(const RelaxSolver* solver, int field);
+
+// After a Chebyshev solve that converged, the sweeps plain Jacobi takes from
+// the same start to pass the same test, exact up to rounding. Counted on each
+// call, from the sine modes of the first sweep, in a couple of transforms of
+// the grid, and from the solver's current settings, so call it before changing
+// them. 0 otherwise, or if it could not be counted.
+int relaxGetJacobiEstimate(const RelaxSolver* solver);
+
+size_t relaxGetFootprint(const RelaxSolver* solver);
+
+const char* relaxGetMemoryBacking(const RelaxSolver* solver);
+
+const char* relaxGetAffinityName(const RelaxSolver* solver);
+
+int relaxGetWorkerPlacement(const RelaxSolver* solver, int worker, int* cpu,
+    int* firstRow, int* lastRow);
+
+const char* relaxMethodName(RelaxMethod method);
+
+const char* relaxStencilName(RelaxStencil stencil);
+
+// Starts the given number of threads, which wait for batches until the pool is
+// destroyed.
+RelaxPool* relaxCreatePool(int workers);
+
+// Solves every solver of the batch, each on a single pool thread, and returns
+// once all are done. Configure the solvers with one worker, so no further
+// threads are created per solve. Returns RELAX_ERROR if any solve failed;
+// relaxGetStatus tells which.
+int relaxSolveBatch(RelaxPool* pool, RelaxSolver** solvers, int count);
+
+void relaxDestroyPool(RelaxPool* pool);
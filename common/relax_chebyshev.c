@@ -0,0 +1,893 @@
+/**
+ * @file relax_chebyshev.c
+ * @brief Source file for the Chebyshev method: Jacobi sweeps accelerated by
+ * Chebyshev semi-iteration, split over the workers.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Each sweep computes the Jacobi update J(u) of the current grid as usual, then
+ * extrapolates from the grid before it:
+ *
+ *     next = previous + weight * (J(u) - previous)
+ *
+ * With weights from the Chebyshev recurrence for a spectral radius rho of the
+ * Jacobi sweep, the error after k sweeps shrinks like rho^k / T_k(1 / rho)
+ * rather than rho^k, which is roughly the square root of the number of sweeps
+ * plain Jacobi needs. Every cell is still updated only from the last two grids,
+ * so the workers need no locks and no colouring, and the result does not
+ * depend on how the grid is split.
+ *
+ * rho is computed from the grid dimensions and the stencil: the slowest mode is
+ * the lowest sine mode, whose value is known (see relax_direct.c). Adaptively,
+ * it starts at 0, plain Jacobi, and is raised whenever the change shrinks more
+ * slowly than the current rho promises, in the manner of Hageman and Young.
+ *
+ * Each sweep stops on the same test as plain Jacobi: no cell of the current
+ * grid would move by more than the precision under a Jacobi sweep.
+ *
+ * For the report of the saving, countJacobiSweeps counts the sweeps plain
+ * Jacobi takes from the same start. The spectral radius alone would not do:
+ * until the faster modes have died away, which at loose precisions is never,
+ * the change shrinks much faster than the radius says.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fft.h"
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+// Sweeps after a (re)start before the adaptive estimate is tested, so a cycle
+// is long enough to measure a rate from.
+#define CHEBYSHEV_MIN_CYCLE 8
+
+// A cycle must shrink the change to at least (its promised factor)^this, or
+// the estimate is raised. Below 1, so noise does not raise it needlessly.
+#define CHEBYSHEV_DAMPING 0.75
+
+// Estimates are kept below 1, where the weights would no longer be defined.
+#define CHEBYSHEV_MAX_BOUND (1.0 - 1e-12)
+
+
+typedef struct
+{
+    RelaxSolver* solver;
+    // The current and the previous grid, which swap roles every sweep.
+    double* grids[2];
+    // Largest change of each worker, by the parity of the sweep, so a worker
+    // that has moved on does not overwrite a value another is still reading.
+    double* changes;
+    // Worker 0's cancel request for each sweep, by parity. Read after the next
+    // barrier, so every worker sees it at the same sweep.
+    int cancelRequests[2];
+    // One row of scratch space per worker, for the Jacobi update.
+    double** scratch;
+    pthread_barrier_t barrier;
+} ChebyshevContext;
+
+typedef struct
+{
+    ChebyshevContext* context;
+    int tid;
+} ChebyshevArgs;
+
+// The first Jacobi change of a start grid in sine space, for
+// countJacobiSweeps. The interior is one block of planes of rows of columns;
+// a 2D grid is a single plane.
+typedef struct
+{
+    const RelaxSolver* solver;
+    // Interior cells along each axis: planes, rows and columns.
+    int lengths[3];
+    unsigned long cells;
+    // Undoes the scaling of a forward and an inverse transform of the block.
+    double scale;
+    DstPlan plans[3];
+    // 2 cos(pi (k + 1) / (n + 1)) for each mode k along each axis.
+    double* cosines[3];
+    // The cell of the largest change last seen, and the value there of each
+    // mode along each axis.
+    int peak[3];
+    double* sines[3];
+    // The change along the line through the peak on each axis.
+    double* sums[3];
+    // The sine modes of the first change.
+    double* modes;
+    // The modes after some sweeps, and their transform back to the grid.
+    double* work;
+    // Two lines gathered along a strided axis, and the transform's scratch.
+    double* lines;
+    double complex* scratch;
+} JacobiModes;
+
+// The largest change after some sweeps, or a lower bound on it.
+typedef double (*ChangeMeasure)(JacobiModes* modes, int sweeps);
+
+
+// Function declarations
+static void* chebyshevWorker(void* arg);
+static void waitForSweep(pthread_barrier_t* barrier);
+static void restartChebyshev(ChebyshevSchedule* schedule, double bound);
+static double takeFirstChange(JacobiModes* modes, const double* grid);
+static int sweepsToConverge(JacobiModes* modes, double first,
+    double precision);
+static int firstWithin(JacobiModes* modes, ChangeMeasure measure, int low,
+    double lowValue, int high, double highValue, double precision);
+static double amplitudeSum(const JacobiModes* modes, double* radius);
+static double crossChange(JacobiModes* modes, int sweeps);
+static double largestChange(JacobiModes* modes, int sweeps);
+static void movePeak(JacobiModes* modes, const int cell[3]);
+static double modeValue(const JacobiModes* modes, int p, int r, int c);
+static void transformAxis(JacobiModes* modes, double* block, int axis);
+
+
+// Function definitions
+int solveChebyshev(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    int workers = solver->workers;
+    if (extents->planes > 1 && selectJacobiRow3D(solver->stencil) == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    size_t rowBytes = sizeof(double) * (unsigned long) extents->columns;
+    size_t arenaBytes = (doubleMatrixArenaSize(extents) * 2) +
+        arenaSizeFor(sizeof(double) * 2 * (unsigned long) workers) +
+        arenaSizeFor(sizeof(double*) * (unsigned long) workers) +
+        (arenaSizeFor(rowBytes) * (unsigned long) workers) +
+        arenaSizeFor(sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    ChebyshevContext context;
+    context.solver = solver;
+    context.grids[0] = createDoubleMatrix(solver->arena, extents);
+    context.grids[1] = createDoubleMatrix(solver->arena, extents);
+    context.changes = (double*) solverAlloc(solver, sizeof(double) * 2 *
+        (unsigned long) workers);
+    context.scratch = (double**) solverAlloc(solver, sizeof(double*) *
+        (unsigned long) workers);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (context.grids[0] == NULL || context.grids[1] == NULL ||
+        context.changes == NULL || context.scratch == NULL ||
+        solver->placements == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        context.scratch[i] = (double*) solverAlloc(solver, rowBytes);
+        if (context.scratch[i] == NULL)
+        {
+            return RELAX_ERROR;
+        }
+    }
+    context.cancelRequests[0] = 0;
+    context.cancelRequests[1] = 0;
+    solver->placementCount = workers;
+
+    if (pthread_barrier_init(&context.barrier, NULL,
+        (unsigned int) workers) != 0)
+    {
+        perror("pthread_barrier_init() error");
+        return RELAX_ERROR;
+    }
+
+    pthread_t threads[workers];
+    ChebyshevArgs args[workers];
+
+    int status = RELAX_OK;
+    for (int i = 0; i < workers; i++)
+    {
+        args[i].context = &context;
+        args[i].tid = i;
+        if (workers == 1)
+        {
+            chebyshevWorker(&args[i]);
+            break;
+        }
+        if (pthread_create(&threads[i], NULL, chebyshevWorker, &args[i]) != 0)
+        {
+            // The other workers would wait at the barrier forever.
+            perror("pthread_create() error");
+            exit(-1);
+        }
+    }
+
+    for (int i = 0; i < workers && workers > 1; i++)
+    {
+        if (pthread_join(threads[i], NULL) != 0)
+        {
+            perror("pthread_join() error");
+            status = RELAX_ERROR;
+        }
+    }
+    pthread_barrier_destroy(&context.barrier);
+
+    // The grids swap every sweep, so the last one written depends on the
+    // number of sweeps.
+    solver->grid = context.grids[solver->iterations % 2];
+
+    if (status == RELAX_OK && atomic_load(&solver->cancelled))
+    {
+        status = RELAX_CANCELLED;
+    }
+    solver->chebyshevConverged = (status == RELAX_OK);
+    solver->chebyshevFromGuess = true;
+    return status;
+}
+
+// Spectral radius of the Jacobi sweep of the grid: its value for the lowest
+// sine mode along every axis.
+double chebyshevBound(const RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    double vertical = cos(M_PI / (extents->rows - 1));
+    double horizontal = cos(M_PI / (extents->columns - 1));
+    if (extents->planes > 1)
+    {
+        // The 7-point stencil.
+        return (vertical + horizontal + cos(M_PI / (extents->planes - 1))) /
+            3.0;
+    }
+    return 1.0 - directDenominator(solver, 2.0 * vertical, 2.0 * horizontal);
+}
+
+void startChebyshev(ChebyshevSchedule* schedule, const RelaxSolver* solver)
+{
+    schedule->adaptive = solver->chebyshevAdaptive;
+    restartChebyshev(schedule, schedule->adaptive ? 0.0 :
+        chebyshevBound(solver));
+}
+
+// Takes the largest change of the sweep just run, and sets the weight of the
+// next.
+void advanceChebyshev(ChebyshevSchedule* schedule, double maxChange)
+{
+    if (schedule->step == 0)
+    {
+        schedule->cycleChange = maxChange;
+    }
+    schedule->step++;
+
+    double bound = schedule->bound;
+    int cycle = schedule->step - 1;
+    if (schedule->adaptive && cycle >= CHEBYSHEV_MIN_CYCLE &&
+        schedule->cycleChange > 0.0 && maxChange > 0.0)
+    {
+        // Reduction over the cycle, against the reduction the estimate
+        // promises: 1 / T_k(1 / bound), where T_k is the Chebyshev polynomial.
+        double reduction = maxChange / schedule->cycleChange;
+        double promised = (bound > 0.0) ?
+            1.0 / cosh(cycle * acosh(1.0 / bound)) : 0.0;
+        if (reduction > pow(promised, CHEBYSHEV_DAMPING))
+        {
+            // The dominant mode lambda shrinks by T_k(lambda / bound) /
+            // T_k(1 / bound). Solving for lambda gives the new estimate; from
+            // plain Jacobi that is just the rate per sweep.
+            double estimate = (bound > 0.0) ?
+                bound * cosh(acosh(reduction / promised) / cycle) :
+                pow(reduction, 1.0 / cycle);
+            if (estimate > bound)
+            {
+                restartChebyshev(schedule, fmin(estimate,
+                    CHEBYSHEV_MAX_BOUND));
+                return;
+            }
+        }
+    }
+
+    // The first sweep of a cycle is plain Jacobi.
+    double square = bound * bound;
+    if (schedule->step == 1)
+    {
+        schedule->weight = 1.0 / (1.0 - (square / 2.0));
+    }
+    else
+    {
+        schedule->weight = 1.0 / (1.0 - (square * schedule->weight / 4.0));
+    }
+}
+
+// Starts a new cycle from the current grid, whose first sweep is plain Jacobi.
+static void restartChebyshev(ChebyshevSchedule* schedule, double bound)
+{
+    schedule->bound = bound;
+    schedule->step = 0;
+    schedule->weight = 1.0;
+    schedule->cycleChange = 0.0;
+}
+
+// Replaces a row of the previous grid with the next, extrapolated from it
+// along the Jacobi update of the current grid. The boundary cells at either
+// end are left alone. A weight of 1 is plain Jacobi, and copies the update
+// exactly.
+void chebyshevRow(double* previous, const double* update, int columns,
+    double weight)
+{
+    if (weight == 1.0)
+    {
+        memcpy(previous + 1, update + 1, sizeof(double) *
+            (unsigned long) (columns - 2));
+        return;
+    }
+    for (int j = 1; j < columns - 1; j++)
+    {
+        previous[j] += weight * (update[j] - previous[j]);
+    }
+}
+
+// Sweeps plain Jacobi takes from the start grid, with or without the initial
+// guess, to stop on the same test as the solvers: the first sweep that changes
+// no cell by more than the precision. Jacobi is linear, so the change after k
+// sweeps is J^k times the first change, and the sine modes diagonalise J (see
+// relax_direct.c). The count is found in sine space rather than by sweeping,
+// which at small precisions would take far longer than the Chebyshev solve.
+// Returns 0 if it cannot be counted.
+int countJacobiSweeps(const RelaxSolver* solver, bool fromGuess)
+{
+    const GridExtents* extents = &solver->extents;
+    bool volume = (extents->planes > 1);
+    if (solver->precision <= 0.0 || extents->rows < 3 ||
+        extents->columns < 3 ||
+        (volume && selectJacobiRow3D(solver->stencil) == NULL))
+    {
+        return 0;
+    }
+
+    JacobiModes modes;
+    modes.solver = solver;
+    modes.lengths[0] = volume ? extents->planes - 2 : 1;
+    modes.lengths[1] = extents->rows - 2;
+    modes.lengths[2] = extents->columns - 2;
+    modes.cells = 1;
+    modes.scale = 1.0;
+    int longest = 1;
+    size_t scratchBytes = 0;
+    size_t arenaBytes = doubleMatrixArenaSize(extents);
+    for (int a = 0; a < 3; a++)
+    {
+        int length = modes.lengths[a];
+        modes.cells *= (unsigned long) length;
+        modes.scale *= 2.0 / (length + 1);
+        longest = length > longest ? length : longest;
+        size_t bytes = dstScratchSize(length);
+        scratchBytes = bytes > scratchBytes ? bytes : scratchBytes;
+        arenaBytes += dstPlanArenaSize(length) +
+            (arenaSizeFor(sizeof(double) * (unsigned long) length) * 3);
+    }
+    arenaBytes += arenaSizeFor(sizeof(double) * modes.cells) +
+        arenaSizeFor(sizeof(double) * 2 * (unsigned long) longest) +
+        arenaSizeFor(scratchBytes);
+
+    Arena* arena = createArena(arenaBytes);
+    if (arena == NULL)
+    {
+        return 0;
+    }
+    double* grid = createDoubleMatrix(arena, extents);
+    modes.modes = (double*) arenaAlloc(arena, sizeof(double) * modes.cells);
+    modes.lines = (double*) arenaAlloc(arena, sizeof(double) * 2 *
+        (unsigned long) longest);
+    modes.scratch = (double complex*) arenaAlloc(arena, scratchBytes);
+    bool ready = (grid != NULL && modes.modes != NULL &&
+        modes.lines != NULL && modes.scratch != NULL);
+    for (int a = 0; a < 3 && ready; a++)
+    {
+        int length = modes.lengths[a];
+        size_t bytes = sizeof(double) * (unsigned long) length;
+        modes.cosines[a] = (double*) arenaAlloc(arena, bytes);
+        modes.sines[a] = (double*) arenaAlloc(arena, bytes);
+        modes.sums[a] = (double*) arenaAlloc(arena, bytes);
+        ready = (modes.cosines[a] != NULL && modes.sines[a] != NULL &&
+            modes.sums[a] != NULL &&
+            createDstPlan(&modes.plans[a], arena, length) == 0);
+        for (int k = 0; ready && k < length; k++)
+        {
+            modes.cosines[a][k] = 2.0 * cos(M_PI * (k + 1) / (length + 1));
+        }
+    }
+    if (!ready)
+    {
+        freeArena(arena);
+        return 0;
+    }
+
+    int stackRows = extents->rows * extents->planes;
+    if (fromGuess)
+    {
+        initSolverRows(solver, grid, 0, stackRows);
+    }
+    else
+    {
+        initDoubleMatrixRows(grid, extents, 0, stackRows,
+            &solver->boundaries);
+    }
+    double first = takeFirstChange(&modes, grid);
+
+    // The start grid is done with, and has room for the interior.
+    modes.work = grid;
+    int sweeps = 1;
+    if (first > solver->precision)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            transformAxis(&modes, modes.modes, a);
+        }
+        int later = sweepsToConverge(&modes, first, solver->precision);
+        sweeps = (later > 0) ? later + 1 : 0;
+    }
+    freeArena(arena);
+    return sweeps;
+}
+
+static void* chebyshevWorker(void* arg)
+{
+    ChebyshevArgs* args = (ChebyshevArgs*) arg;
+    ChebyshevContext* context = args->context;
+    RelaxSolver* solver = context->solver;
+    int tid = args->tid;
+    int workers = solver->workers;
+    double* scratch = context->scratch[tid];
+
+    const GridExtents* extents = &solver->extents;
+    int rows = extents->rows;
+    int columns = extents->columns;
+    int planes = extents->planes;
+    long planeSize = (long) rows * columns;
+    bool volume = (planes > 1);
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, 0);
+    JacobiRow3DKernel relaxVolumeRow = selectJacobiRow3D(solver->stencil);
+
+    int cpu = affinityCpuFor(&solver->affinity, tid);
+    if (cpu >= 0 && pinCurrentThread(cpu) != 0)
+    {
+        cpu = -1;
+    }
+
+    // First touch, as for the threaded method. The band is also the rows this
+    // worker relaxes.
+    int stackRows = rows * planes;
+    int firstRow = (int) ((long) tid * stackRows / workers);
+    int lastRow = (int) ((long) (tid + 1) * stackRows / workers);
+    for (int i = 0; i < 2; i++)
+    {
+        initSolverRows(solver, context->grids[i] + ((long) firstRow * columns),
+            firstRow, lastRow);
+    }
+    solver->placements[tid].cpu = cpu;
+    solver->placements[tid].firstRow = firstRow;
+    solver->placements[tid].lastRow = lastRow - 1;
+
+    // Every worker follows the same schedule from the same changes.
+    ChebyshevSchedule schedule;
+    startChebyshev(&schedule, solver);
+    int iterations = 0;
+    waitForSweep(&context->barrier);
+
+    while (true)
+    {
+        const double* current = context->grids[iterations % 2];
+        double* previous = context->grids[(iterations + 1) % 2];
+        double weight = schedule.weight;
+
+        double maxChange = 0.0;
+        for (int r = firstRow; r < lastRow; r++)
+        {
+            int x = r % rows;
+            int z = r / rows;
+            if (x == 0 || x == rows - 1 || (volume && (z == 0 ||
+                z == planes - 1)))
+            {
+                continue;
+            }
+
+            const double* row = current + ((long) r * columns);
+            double change;
+            if (volume)
+            {
+                change = relaxVolumeRow(scratch, row - planeSize,
+                    row - columns, row, row + columns, row + planeSize, 1,
+                    columns - 1, &solver->weights);
+            }
+            else
+            {
+                change = relaxRow(scratch, row - columns, row, row + columns,
+                    1, columns - 1, &solver->weights);
+            }
+            chebyshevRow(previous + ((long) r * columns), scratch, columns,
+                weight);
+            maxChange = fmax(maxChange, change);
+        }
+
+        int parity = iterations % 2;
+        context->changes[(parity * workers) + tid] = maxChange;
+        waitForSweep(&context->barrier);
+        iterations++;
+
+        // A cancel request made after the last sweep is seen by everyone now.
+        bool cancelled = context->cancelRequests[1 - parity] != 0;
+        for (int i = 0; i < workers; i++)
+        {
+            maxChange = fmax(maxChange, context->changes[(parity * workers) +
+                i]);
+        }
+        advanceChebyshev(&schedule, maxChange);
+
+        if (tid == 0)
+        {
+            context->cancelRequests[parity] = reportProgress(solver,
+                iterations, maxChange, 0.0);
+        }
+        if (cancelled || maxChange <= solver->precision)
+        {
+            break;
+        }
+    }
+
+    if (tid == 0)
+    {
+        solver->iterations = iterations;
+    }
+    return NULL;
+}
+
+static void waitForSweep(pthread_barrier_t* barrier)
+{
+    int ok = pthread_barrier_wait(barrier);
+    if (ok != 0 && ok != PTHREAD_BARRIER_SERIAL_THREAD)
+    {
+        perror("pthread_barrier_wait() error");
+        exit(-1);
+    }
+}
+
+// Takes the first Jacobi change of the grid over the interior into the modes,
+// and returns its largest cell: the largest change of the first sweep. The
+// peak moves to that cell. The grid rows are passed from their first interior
+// cell, so that cell y of a mode row is column y + 1.
+static double takeFirstChange(JacobiModes* modes, const double* grid)
+{
+    const RelaxSolver* solver = modes->solver;
+    const GridExtents* extents = &solver->extents;
+    int rows = extents->rows;
+    int columns = extents->columns;
+    long planeSize = (long) rows * columns;
+    bool volume = (extents->planes > 1);
+    int interiorColumns = modes->lengths[2];
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, 0);
+    JacobiRow3DKernel relaxVolumeRow = selectJacobiRow3D(solver->stencil);
+
+    double largest = 0.0;
+    int peak[3] = { 0, 0, 0 };
+    double* out = modes->modes;
+    for (int z = 0; z < modes->lengths[0]; z++)
+    {
+        int plane = volume ? z + 1 : 0;
+        for (int x = 1; x < rows - 1; x++)
+        {
+            const double* row = grid + ((((long) plane * rows) + x) *
+                columns) + 1;
+            if (volume)
+            {
+                relaxVolumeRow(out, row - planeSize, row - columns, row,
+                    row + columns, row + planeSize, 0, interiorColumns,
+                    &solver->weights);
+            }
+            else
+            {
+                relaxRow(out, row - columns, row, row + columns, 0,
+                    interiorColumns, &solver->weights);
+            }
+            for (int y = 0; y < interiorColumns; y++)
+            {
+                out[y] -= row[y];
+                if (fabs(out[y]) > largest)
+                {
+                    largest = fabs(out[y]);
+                    peak[0] = z;
+                    peak[1] = x - 1;
+                    peak[2] = y;
+                }
+            }
+            out += interiorColumns;
+        }
+    }
+    movePeak(modes, peak);
+    return largest;
+}
+
+// The fewest sweeps after the first whose change is within the precision, or
+// 0 if there are too many to count. The largest change never grows, as every
+// stencil averages its neighbours with positive weights. The count is found on
+// lower bounds that take a pass over the modes each, and then checked with a
+// transform back to the grid, which is usually enough once.
+static int sweepsToConverge(JacobiModes* modes, double first,
+    double precision)
+{
+    // Every sine mode peaks at 1, so the sum of the amplitudes bounds the
+    // largest change from above, and no mode shrinks by less than the radius
+    // per sweep. The bound stands in for the change at high.
+    double radius;
+    double sum = amplitudeSum(modes, &radius);
+    double bound = ceil(log(precision / sum) / log(radius));
+    if (!(bound < INT_MAX))
+    {
+        return 0;
+    }
+    int high = (bound > 1.0) ? (int) bound : 1;
+    double highValue = sum * pow(radius, high);
+
+    int low = 0;
+    double lowValue = first;
+    while (true)
+    {
+        int k = firstWithin(modes, crossChange, low, lowValue, high,
+            highValue, precision);
+        if (k == high)
+        {
+            return high;
+        }
+        // Above the precision one sweep earlier, at least on the lines.
+        double value = largestChange(modes, k);
+        if (value <= precision)
+        {
+            return k;
+        }
+        low = k;
+        lowValue = value;
+    }
+}
+
+// The first sweep count in (low, high] at which the measure is within the
+// precision, given that the largest change is above it at low and within it
+// at high. The log of the change falls almost linearly once the fast modes
+// have gone, so this is regula falsi on log(measure / precision), with the
+// Illinois fix.
+static int firstWithin(JacobiModes* modes, ChangeMeasure measure, int low,
+    double lowValue, int high, double highValue, double precision)
+{
+    double lowExcess = log(lowValue / precision);
+    double highExcess = log(highValue / precision);
+    int retained = 0;
+    while (high - low > 1)
+    {
+        // A change of exactly 0 leaves nothing to interpolate: bisect.
+        int k = low + ((high - low) / 2);
+        if (isfinite(highExcess))
+        {
+            k = low + (int) ((high - low) * (lowExcess /
+                (lowExcess - highExcess)));
+        }
+        k = (k <= low) ? low + 1 : (k >= high) ? high - 1 : k;
+
+        double excess = log(measure(modes, k) / precision);
+        if (excess > 0.0)
+        {
+            low = k;
+            lowExcess = excess;
+            highExcess /= (retained > 0) ? 2.0 : 1.0;
+            retained = 1;
+        }
+        else
+        {
+            high = k;
+            highExcess = excess;
+            lowExcess /= (retained < 0) ? 2.0 : 1.0;
+            retained = -1;
+        }
+    }
+    return high;
+}
+
+// Sum of the amplitudes of the first change's modes, scaled to the grid, and
+// in radius the largest value of a sweep for any mode, in magnitude.
+static double amplitudeSum(const JacobiModes* modes, double* radius)
+{
+    const double* in = modes->modes;
+    double sum = 0.0;
+    double largest = 0.0;
+    for (int p = 0; p < modes->lengths[0]; p++)
+    {
+        for (int r = 0; r < modes->lengths[1]; r++)
+        {
+            for (int c = 0; c < modes->lengths[2]; c++)
+            {
+                sum += fabs(*in++);
+                largest = fmax(largest, fabs(modeValue(modes, p, r, c)));
+            }
+        }
+    }
+    *radius = largest;
+    return sum * modes->scale;
+}
+
+// Largest change on the lines through the peak along every axis, which bounds
+// the largest change from below. Each line is the modes summed against their
+// values at the peak along the other axes, and a transform along its own. The
+// peak then moves to the largest cell on the lines, so it follows the largest
+// change as the sweeps go on.
+static double crossChange(JacobiModes* modes, int sweeps)
+{
+    const int* lengths = modes->lengths;
+    for (int a = 0; a < 3; a++)
+    {
+        for (int k = 0; k < lengths[a]; k++)
+        {
+            modes->sums[a][k] = 0.0;
+        }
+    }
+
+    const double* in = modes->modes;
+    const double* const* sines = (const double* const*) modes->sines;
+    for (int p = 0; p < lengths[0]; p++)
+    {
+        for (int r = 0; r < lengths[1]; r++)
+        {
+            double weight = sines[0][p] * sines[1][r];
+            double across = 0.0;
+            for (int c = 0; c < lengths[2]; c++)
+            {
+                double amplitude = *in++ * pow(modeValue(modes, p, r, c),
+                    sweeps);
+                modes->sums[2][c] += amplitude * weight;
+                across += amplitude * sines[2][c];
+            }
+            modes->sums[1][r] += across * sines[0][p];
+            modes->sums[0][p] += across * sines[1][r];
+        }
+    }
+
+    double largest = 0.0;
+    int peak[3] = { modes->peak[0], modes->peak[1], modes->peak[2] };
+    for (int a = 0; a < 3; a++)
+    {
+        if (lengths[a] > 1)
+        {
+            dstPair(&modes->plans[a], modes->sums[a], NULL, modes->scratch);
+        }
+        for (int k = 0; k < lengths[a]; k++)
+        {
+            if (fabs(modes->sums[a][k]) > largest)
+            {
+                largest = fabs(modes->sums[a][k]);
+                for (int b = 0; b < 3; b++)
+                {
+                    peak[b] = (b == a) ? k : modes->peak[b];
+                }
+            }
+        }
+    }
+    movePeak(modes, peak);
+    return largest * modes->scale;
+}
+
+// Largest cell of the change after some sweeps: each mode of the first change
+// times the sweep's value for it, to the power, transformed back to the grid.
+// The peak moves to that cell.
+static double largestChange(JacobiModes* modes, int sweeps)
+{
+    const double* in = modes->modes;
+    double* out = modes->work;
+    for (int p = 0; p < modes->lengths[0]; p++)
+    {
+        for (int r = 0; r < modes->lengths[1]; r++)
+        {
+            for (int c = 0; c < modes->lengths[2]; c++)
+            {
+                *out++ = *in++ * pow(modeValue(modes, p, r, c), sweeps);
+            }
+        }
+    }
+    for (int a = 0; a < 3; a++)
+    {
+        transformAxis(modes, modes->work, a);
+    }
+
+    double largest = 0.0;
+    unsigned long cell = 0;
+    for (unsigned long l = 0; l < modes->cells; l++)
+    {
+        if (fabs(modes->work[l]) > largest)
+        {
+            largest = fabs(modes->work[l]);
+            cell = l;
+        }
+    }
+    int columns = modes->lengths[2];
+    int rows = modes->lengths[1];
+    unsigned long line = cell / (unsigned long) columns;
+    int peak[3] = { (int) (line / (unsigned long) rows),
+        (int) (line % (unsigned long) rows),
+        (int) (cell % (unsigned long) columns) };
+    movePeak(modes, peak);
+    return largest * modes->scale;
+}
+
+// Moves the peak to a cell of the block.
+static void movePeak(JacobiModes* modes, const int cell[3])
+{
+    for (int a = 0; a < 3; a++)
+    {
+        int length = modes->lengths[a];
+        modes->peak[a] = cell[a];
+        for (int k = 0; k < length; k++)
+        {
+            modes->sines[a][k] = sin(M_PI * (cell[a] + 1) * (k + 1) /
+                (length + 1));
+        }
+    }
+}
+
+// The Jacobi sweep's value for a sine mode: what it multiplies the mode by.
+static double modeValue(const JacobiModes* modes, int p, int r, int c)
+{
+    double vertical = modes->cosines[1][r];
+    double horizontal = modes->cosines[2][c];
+    if (modes->solver->extents.planes > 1)
+    {
+        // The 7-point stencil.
+        return (modes->cosines[0][p] + vertical + horizontal) / 6.0;
+    }
+    return 1.0 - directDenominator(modes->solver, vertical, horizontal);
+}
+
+// Transforms every line of a block along one axis. Lines along the columns are
+// contiguous; the others are gathered two at a time.
+static void transformAxis(JacobiModes* modes, double* block, int axis)
+{
+    int length = modes->lengths[axis];
+    if (length < 2)
+    {
+        // A transform of length 1 is the identity.
+        return;
+    }
+    const DstPlan* plan = &modes->plans[axis];
+    long stride = 1;
+    for (int a = axis + 1; a < 3; a++)
+    {
+        stride *= modes->lengths[a];
+    }
+    if (stride == 1)
+    {
+        dstRows(plan, block, 0, (int) (modes->cells / (unsigned long) length),
+            modes->scratch);
+        return;
+    }
+
+    long span = stride * length;
+    double* first = modes->lines;
+    double* second = modes->lines + length;
+    for (long start = 0; start < (long) modes->cells; start += span)
+    {
+        for (long i = 0; i < stride; i += 2)
+        {
+            double* line = block + start + i;
+            bool pair = (i + 1 < stride);
+            for (int j = 0; j < length; j++)
+            {
+                first[j] = line[j * stride];
+                second[j] = pair ? line[(j * stride) + 1] : 0.0;
+            }
+            dstPair(plan, first, pair ? second : NULL, modes->scratch);
+            for (int j = 0; j < length; j++)
+            {
+                line[j * stride] = first[j];
+                if (pair)
+                {
+                    line[(j * stride) + 1] = second[j];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,325 @@
+/**
+ * @file relax_direct.c
+ * @brief Source file for the direct method: an exact solve of the grid with
+ * discrete sine transforms, instead of relaxing it sweep by sweep.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Relaxation converges to the grid u whose interior equals the stencil average
+ * of its neighbours, u = S u + b, where b is what the fixed edges contribute to
+ * each interior cell. Every 2D stencil here is a combination of shifts along
+ * the rows and the columns, so the 2D DST-I diagonalises S: in sine space
+ * each mode of u is just b over (1 - the stencil's value for that mode). The
+ * solve is a transform of b, a division and the inverse transform, in
+ * O(N^2 log N) rather than thousands of sweeps. Up to rounding, it is the
+ * answer every iterative method is heading for, so it also makes a quick
+ * reference for them.
+ *
+ * The workers transform bands of rows, then transpose the grid so that its
+ * columns are rows and transform those. A barrier separates the phases.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fft.h"
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+// Side of the blocks the transpose works through, so both grids stay in cache.
+#define DIRECT_TRANSPOSE_BLOCK 32
+
+
+typedef struct
+{
+    RelaxSolver* solver;
+    // Interior of the grid: the right-hand side b, then its transform.
+    double* work;
+    // The interior transposed, so the columns can be transformed as rows.
+    double* transposed;
+    DstPlan rowPlan;
+    DstPlan columnPlan;
+    double complex** scratch;
+    pthread_barrier_t barrier;
+} DirectContext;
+
+typedef struct
+{
+    DirectContext* context;
+    int tid;
+} DirectArgs;
+
+
+// Function declarations
+static void* directWorker(void* arg);
+static void waitForPhase(pthread_barrier_t* barrier);
+static void transposeRows(double* out, const double* in, int inRows,
+    int inColumns, int first, int last);
+
+
+// Function definitions
+int solveDirect(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    if (extents->planes > 1)
+    {
+        return RELAX_ERROR;
+    }
+
+    int workers = solver->workers;
+    int interiorRows = extents->rows - 2;
+    int interiorColumns = extents->columns - 2;
+    unsigned long interiorCells = (unsigned long) interiorRows *
+        (unsigned long) interiorColumns;
+
+    DirectContext context;
+    context.solver = solver;
+    size_t scratchBytes = directScratchSize(interiorRows, interiorColumns);
+    size_t arenaBytes = doubleMatrixArenaSize(extents) +
+        (arenaSizeFor(sizeof(double) * interiorCells) * 2) +
+        dstPlanArenaSize(interiorColumns) + dstPlanArenaSize(interiorRows) +
+        arenaSizeFor(sizeof(double complex*) * (unsigned long) workers) +
+        (arenaSizeFor(scratchBytes) * (unsigned long) workers) +
+        arenaSizeFor(sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    solver->grid = createDoubleMatrix(solver->arena, extents);
+    context.work = (double*) solverAlloc(solver, sizeof(double) *
+        interiorCells);
+    context.transposed = (double*) solverAlloc(solver, sizeof(double) *
+        interiorCells);
+    context.scratch = (double complex**) solverAlloc(solver,
+        sizeof(double complex*) * (unsigned long) workers);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (solver->grid == NULL || context.work == NULL ||
+        context.transposed == NULL || context.scratch == NULL ||
+        solver->placements == NULL ||
+        createDstPlan(&context.rowPlan, solver->arena, interiorColumns) != 0 ||
+        createDstPlan(&context.columnPlan, solver->arena, interiorRows) != 0)
+    {
+        return RELAX_ERROR;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        context.scratch[i] = (double complex*) solverAlloc(solver,
+            scratchBytes);
+        if (context.scratch[i] == NULL)
+        {
+            return RELAX_ERROR;
+        }
+    }
+    solver->placementCount = workers;
+
+    if (pthread_barrier_init(&context.barrier, NULL,
+        (unsigned int) workers) != 0)
+    {
+        perror("pthread_barrier_init() error");
+        return RELAX_ERROR;
+    }
+
+    pthread_t threads[workers];
+    DirectArgs args[workers];
+
+    int status = RELAX_OK;
+    for (int i = 0; i < workers; i++)
+    {
+        args[i].context = &context;
+        args[i].tid = i;
+        if (workers == 1)
+        {
+            directWorker(&args[i]);
+            break;
+        }
+        if (pthread_create(&threads[i], NULL, directWorker, &args[i]) != 0)
+        {
+            // The other workers would wait at the barrier forever.
+            perror("pthread_create() error");
+            exit(-1);
+        }
+    }
+
+    for (int i = 0; i < workers && workers > 1; i++)
+    {
+        if (pthread_join(threads[i], NULL) != 0)
+        {
+            perror("pthread_join() error");
+            status = RELAX_ERROR;
+        }
+    }
+    pthread_barrier_destroy(&context.barrier);
+
+    // There are no sweeps.
+    solver->iterations = 0;
+    return status;
+}
+
+// Value of 1 - S for the sine mode whose shifts along the columns (up plus
+// down) and along the rows (left plus right) multiply it by vertical and
+// horizontal, each 2 cos(k pi / (n + 1)). Always positive, as the stencils
+// average their neighbours.
+double directDenominator(const RelaxSolver* solver, double vertical,
+    double horizontal)
+{
+    switch (solver->stencil)
+    {
+        case RELAX_STENCIL_9_POINT:
+            return 1.0 - (((4.0 * (vertical + horizontal)) +
+                (vertical * horizontal)) / 20.0);
+        case RELAX_STENCIL_WEIGHTED:
+            return 1.0 - ((solver->weights.vertical * vertical) +
+                (solver->weights.horizontal * horizontal));
+        case RELAX_STENCIL_5_POINT:
+            break;
+    }
+    return 1.0 - ((vertical + horizontal) / 4.0);
+}
+
+// Scratch space one worker needs to transform both the rows and the columns.
+size_t directScratchSize(int interiorRows, int interiorColumns)
+{
+    size_t rows = dstScratchSize(interiorColumns);
+    size_t columns = dstScratchSize(interiorRows);
+    return rows > columns ? rows : columns;
+}
+
+// Transforms rows first to last - 1 of a row-major block, two at a time.
+void dstRows(const DstPlan* plan, double* rows, int first, int last,
+    double complex* scratch)
+{
+    int length = plan->length;
+    for (int i = first; i < last; i += 2)
+    {
+        double* second = (i + 1 < last) ? rows + ((long) (i + 1) * length) :
+            NULL;
+        dstPair(plan, rows + ((long) i * length), second, scratch);
+    }
+}
+
+static void* directWorker(void* arg)
+{
+    DirectArgs* args = (DirectArgs*) arg;
+    DirectContext* context = args->context;
+    RelaxSolver* solver = context->solver;
+    int tid = args->tid;
+    int workers = solver->workers;
+    double complex* scratch = context->scratch[tid];
+
+    const GridExtents* extents = &solver->extents;
+    int columns = extents->columns;
+    int interiorRows = extents->rows - 2;
+    int interiorColumns = columns - 2;
+
+    int cpu = affinityCpuFor(&solver->affinity, tid);
+    if (cpu >= 0 && pinCurrentThread(cpu) != 0)
+    {
+        cpu = -1;
+    }
+
+    // First touch, as for the threaded method.
+    int firstRow = (int) ((long) tid * extents->rows / workers);
+    int lastRow = (int) ((long) (tid + 1) * extents->rows / workers);
+    initDoubleMatrixRows(solver->grid + ((long) firstRow * columns), extents,
+        firstRow, lastRow, &solver->boundaries);
+    solver->placements[tid].cpu = cpu;
+    solver->placements[tid].firstRow = firstRow;
+    solver->placements[tid].lastRow = lastRow - 1;
+    waitForPhase(&context->barrier);
+
+    // Bands of interior rows, and of interior columns after the transpose.
+    int first = (int) ((long) tid * interiorRows / workers);
+    int last = (int) ((long) (tid + 1) * interiorRows / workers);
+    int firstColumn = (int) ((long) tid * interiorColumns / workers);
+    int lastColumn = (int) ((long) (tid + 1) * interiorColumns / workers);
+
+    // The interior is still zero, so one Jacobi sweep of it gives exactly what
+    // the edges contribute: b. The grid rows are passed from their first
+    // interior cell, so that cell y of a work row is column y + 1.
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, 0);
+    for (int i = first; i < last; i++)
+    {
+        const double* row = solver->grid + ((long) (i + 1) * columns) + 1;
+        relaxRow(context->work + ((long) i * interiorColumns), row - columns,
+            row, row + columns, 0, interiorColumns, &solver->weights);
+    }
+    dstRows(&context->rowPlan, context->work, first, last, scratch);
+    waitForPhase(&context->barrier);
+
+    // Along the columns: transform, divide by the symbol of each mode, and
+    // transform back.
+    transposeRows(context->transposed, context->work, interiorRows,
+        interiorColumns, firstColumn, lastColumn);
+    dstRows(&context->columnPlan, context->transposed, firstColumn,
+        lastColumn, scratch);
+    for (int k = firstColumn; k < lastColumn; k++)
+    {
+        double horizontal = 2.0 * cos(M_PI * (k + 1) / (interiorColumns + 1));
+        double* modes = context->transposed + ((long) k * interiorRows);
+        for (int l = 0; l < interiorRows; l++)
+        {
+            double vertical = 2.0 * cos(M_PI * (l + 1) / (interiorRows + 1));
+            modes[l] /= directDenominator(solver, vertical, horizontal);
+        }
+    }
+    dstRows(&context->columnPlan, context->transposed, firstColumn,
+        lastColumn, scratch);
+    waitForPhase(&context->barrier);
+
+    // Back along the rows, undoing the scaling of the four transforms.
+    transposeRows(context->work, context->transposed, interiorColumns,
+        interiorRows, first, last);
+    dstRows(&context->rowPlan, context->work, first, last, scratch);
+    double scale = 4.0 / ((double) (interiorRows + 1) *
+        (double) (interiorColumns + 1));
+    for (int i = first; i < last; i++)
+    {
+        const double* in = context->work + ((long) i * interiorColumns);
+        double* out = solver->grid + ((long) (i + 1) * columns) + 1;
+        for (int j = 0; j < interiorColumns; j++)
+        {
+            out[j] = in[j] * scale;
+        }
+    }
+
+    return NULL;
+}
+
+static void waitForPhase(pthread_barrier_t* barrier)
+{
+    int ok = pthread_barrier_wait(barrier);
+    if (ok != 0 && ok != PTHREAD_BARRIER_SERIAL_THREAD)
+    {
+        perror("pthread_barrier_wait() error");
+        exit(-1);
+    }
+}
+
+// Writes rows first to last - 1 of out, the transpose of in, which has inRows
+// rows of inColumns values. in is read in blocks of rows, so the rows of out
+// being written stay in cache.
+static void transposeRows(double* out, const double* in, int inRows,
+    int inColumns, int first, int last)
+{
+    for (int block = 0; block < inRows; block += DIRECT_TRANSPOSE_BLOCK)
+    {
+        int blockEnd = block + DIRECT_TRANSPOSE_BLOCK;
+        if (blockEnd > inRows)
+        {
+            blockEnd = inRows;
+        }
+        for (int r = first; r < last; r++)
+        {
+            double* target = out + ((long) r * inRows);
+            for (int c = block; c < blockEnd; c++)
+            {
+                target[c] = in[((long) c * inColumns) + r];
+            }
+        }
+    }
+}
@@ -0,0 +1,225 @@
+/**
+ * @file relax_fields.c
+ * @brief Source file for multi-field solves: Jacobi sweeps over several
+ * boundary configurations of the same grid at once, interleaved per cell.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Each cell holds one value per field, so a sweep streams the grid through
+ * memory once for all of them, and the kernels vectorise across the fields (see
+ * stencil.h). The boundaries never change, so rather than copying the grid
+ * before every sweep, as the single field solvers do, two grids take turns to
+ * hold the last sweep, which saves a pass over memory.
+ *
+ * Every field stops on its own largest change, at the same sweep it would have
+ * stopped on its own. It is then copied out to its own grid and its lane
+ * dropped from every cell, so the sweeps that follow only relax the fields
+ * still converging. Each field's result is bit for bit that of a single
+ * RELAX_METHOD_JACOBI solve with its boundaries.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+static void sweepFields(double* grid, const double* copy,
+    const GridExtents* extents, int active, double* changes,
+    FieldsJacobiRowKernel relaxRow, const StencilWeights* weights);
+static void sweepFieldsVolume(double* grid, const double* copy,
+    const GridExtents* extents, int active, double* changes,
+    FieldsJacobiRow3DKernel relaxRow, const StencilWeights* weights);
+
+
+int solveFields(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    int fields = solver->fieldCount;
+    bool volume = (extents->planes > 1);
+    if (volume && selectFieldsJacobiRow3D(solver->stencil, 0) == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    // The two working grids hold the active fields interleaved, and the
+    // results every field's grid in turn.
+    unsigned long cells = gridCells(extents);
+    if (prepareSolve(solver, (fieldsMatrixArenaSize(extents, fields) * 3) +
+        (arenaSizeFor(sizeof(int) * (unsigned long) fields) * 2) +
+        arenaSizeFor(sizeof(double) * (unsigned long) fields)) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    double* grid = createFieldsMatrix(solver->arena, extents, fields);
+    double* next = createFieldsMatrix(solver->arena, extents, fields);
+    FieldSet set;
+    set.active = fields;
+    set.lanes = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) fields);
+    set.results = createFieldsMatrix(solver->arena, extents, fields);
+    set.resultCells = cells;
+    set.iterations = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) fields);
+    double* changes = (double*) solverAlloc(solver, sizeof(double) *
+        (unsigned long) fields);
+    if (grid == NULL || next == NULL || set.lanes == NULL ||
+        set.results == NULL || set.iterations == NULL || changes == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    for (int f = 0; f < fields; f++)
+    {
+        set.lanes[f] = f;
+        set.iterations[f] = 0;
+    }
+    initFieldsMatrixRows(grid, extents, 0, extents->rows * extents->planes,
+        solver->fieldBoundaries, fields);
+    memcpy(next, grid, sizeof(double) * cells * (unsigned long) fields);
+    solver->grid = set.results;
+    solver->resultFields = fields;
+    solver->fieldIterations = set.iterations;
+
+    while (set.active > 0)
+    {
+        int active = set.active;
+        for (int f = 0; f < active; f++)
+        {
+            changes[f] = 0.0;
+        }
+
+        if (volume)
+        {
+            sweepFieldsVolume(next, grid, extents, active, changes,
+                selectFieldsJacobiRow3D(solver->stencil, active),
+                &solver->weights);
+        }
+        else
+        {
+            sweepFields(next, grid, extents, active, changes,
+                selectFieldsJacobiRow(solver->stencil, active),
+                &solver->weights);
+        }
+        double* last = grid;
+        grid = next;
+        next = last;
+        solver->iterations++;
+
+        double maxChange = 0.0;
+        for (int f = 0; f < active; f++)
+        {
+            maxChange = fmax(maxChange, changes[f]);
+        }
+        // A cancelled solve leaves every field where it got to.
+        bool cancelled = (reportProgress(solver, solver->iterations, maxChange,
+            0.0) != 0);
+        if (retireFields(&set, grid, cells, 0, cells, changes,
+            cancelled ? HUGE_VAL : solver->precision, solver->iterations) <
+            active)
+        {
+            // The other grid still has the old lanes.
+            memcpy(next, grid, sizeof(double) * cells *
+                (unsigned long) set.active);
+        }
+        if (cancelled)
+        {
+            return RELAX_CANCELLED;
+        }
+    }
+    return RELAX_OK;
+}
+
+// Copies every field whose change is within precision out of the interleaved
+// grid into its own, and removes its lane from all cells of the grid. Only
+// cells [first, first + count) are copied out, to the start of the field's
+// grid, so a slab with halo layers can keep just its own layers. Returns the
+// fields left.
+int retireFields(FieldSet* set, double* fields, unsigned long cells,
+    unsigned long first, unsigned long count, const double* changes,
+    double precision, int iteration)
+{
+    int active = set->active;
+    int keep[active];
+    int kept = 0;
+    for (int k = 0; k < active; k++)
+    {
+        if (!(changes[k] <= precision))
+        {
+            keep[kept++] = k;
+            continue;
+        }
+
+        int field = set->lanes[k];
+        double* result = set->results + ((unsigned long) field *
+            set->resultCells);
+        const double* lane = fields + (first * (unsigned long) active) +
+            (unsigned long) k;
+        for (unsigned long c = 0; c < count; c++)
+        {
+            result[c] = lane[c * (unsigned long) active];
+        }
+        set->iterations[field] = iteration;
+    }
+    if (kept == active || kept == 0)
+    {
+        set->active = kept;
+        return kept;
+    }
+
+    // Every value moves to a lower or equal index, and is read before anything
+    // is written there, so the lanes can be packed in place.
+    for (unsigned long c = 0; c < cells; c++)
+    {
+        double* to = fields + (c * (unsigned long) kept);
+        const double* from = fields + (c * (unsigned long) active);
+        for (int k = 0; k < kept; k++)
+        {
+            to[k] = from[keep[k]];
+        }
+    }
+    for (int k = 0; k < kept; k++)
+    {
+        set->lanes[k] = set->lanes[keep[k]];
+    }
+    set->active = kept;
+    return kept;
+}
+
+// Relaxes the interior of every active field from the copy of the last sweep,
+// raising changes[f] to the largest change of lane f.
+static void sweepFields(double* grid, const double* copy,
+    const GridExtents* extents, int active, double* changes,
+    FieldsJacobiRowKernel relaxRow, const StencilWeights* weights)
+{
+    long rowLength = (long) extents->columns * active;
+    for (int x = 1; x < extents->rows - 1; x++)
+    {
+        const double* row = copy + ((long) x * rowLength);
+        relaxRow(grid + ((long) x * rowLength), row - rowLength, row,
+            row + rowLength, 1, extents->columns - 1, active, changes,
+            weights);
+    }
+}
+
+// As sweepFields, for volumes.
+static void sweepFieldsVolume(double* grid, const double* copy,
+    const GridExtents* extents, int active, double* changes,
+    FieldsJacobiRow3DKernel relaxRow, const StencilWeights* weights)
+{
+    long rowLength = (long) extents->columns * active;
+    long planeSize = (long) extents->rows * rowLength;
+    for (int z = 1; z < extents->planes - 1; z++)
+    {
+        for (int x = 1; x < extents->rows - 1; x++)
+        {
+            long offset = ((long) z * planeSize) + ((long) x * rowLength);
+            const double* row = copy + offset;
+            relaxRow(grid + offset, row - planeSize, row - rowLength, row,
+                row + rowLength, row + planeSize, 1, extents->columns - 1,
+                active, changes, weights);
+        }
+    }
+}
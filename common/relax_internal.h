@@ -0,0 +1,218 @@
+/**
+ * @file relax_internal.h
+ * @brief Header shared by the librelax sources. Not part of the public API.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "affinity.h"
+#include "arena.h"
+#include "fft.h"
+#include "matrix.h"
+#include "relax.h"
+#include "stencil.h"
+#include "telemetry.h"
+
+
+typedef struct
+{
+    int cpu;
+    int firstRow;
+    int lastRow;
+} WorkerPlacement;
+
+// Weights of the Chebyshev method. Every worker (or rank) keeps its own copy
+// and advances it with the same changes, so they all agree without sharing it.
+typedef struct
+{
+    bool adaptive;
+    // Estimate of the spectral radius of the Jacobi sweep.
+    double bound;
+    // Sweeps since the estimate was last changed, and the weight of the next.
+    int step;
+    double weight;
+    // Change of the first sweep since the estimate last changed.
+    double cycleChange;
+} ChebyshevSchedule;
+
+// Fields of a multi-field solve that are still relaxing. The working grid
+// interleaves one lane per active field in each cell; a field that converges
+// is copied out to its own grid and its lane removed, so later sweeps only
+// relax the fields that still need them.
+typedef struct
+{
+    int active;
+    // Field held by each lane.
+    int* lanes;
+    // The grid of field f starts at results + (f * resultCells).
+    double* results;
+    unsigned long resultCells;
+    // Sweeps after which each field converged.
+    int* iterations;
+} FieldSet;
+
+struct RelaxSolver
+{
+    // Configuration.
+    GridExtents extents;
+    double precision;
+    int workers;
+    RelaxMethod method;
+    Affinity affinity;
+    RelaxBoundaries boundaries;
+    RelaxStencil stencil;
+    StencilWeights weights;
+    int tileSize;
+    double wakeFraction;
+    int rebalanceInterval;
+    char* storePath;
+    int sweepsPerPass;
+    bool chebyshevAdaptive;
+    RelaxProgressCallback progress;
+    void* progressData;
+    char* telemetryPath;
+    // Boundaries of each field of a multi-field solve (see relaxSetFields), or
+    // NULL to solve the single grid with boundaries.
+    RelaxBoundaries* fieldBoundaries;
+    int fieldCount;
+    // Grid to start from (see relaxSetInitialGuess), or NULL to start from
+    // zero. Not owned.
+    const double* initialGuess;
+
+    // State of the last solve. Everything below lives in the arena, apart from
+    // the arena itself.
+    Arena* arena;
+    // For a multi-field solve, every field's grid in turn.
+    double* grid;
+    // What relaxSolve returned, or RELAX_ERROR before the first solve.
+    int status;
+    int iterations;
+    // Fields the result holds, and the sweeps after which each converged
+    // (NULL for a single field).
+    int resultFields;
+    int* fieldIterations;
+    // Whether the last solve was a Chebyshev solve that converged, and from
+    // the initial guess or not, for relaxGetJacobiEstimate.
+    bool chebyshevConverged;
+    bool chebyshevFromGuess;
+    WorkerPlacement* placements;
+    int placementCount;
+    atomic_int cancelled;
+    // File mapping holding the grid of an out-of-core solve, or NULL, and the
+    // file, open while the mapping is.
+    void* storeMapping;
+    size_t storeLength;
+    int storeFd;
+    // Telemetry stream of the solve in progress, or NULL.
+    Telemetry* telemetry;
+};
+
+
+// Kernels of the stencil engine, instantiated in relax_kernels.c. Each returns
+// the largest change it made.
+typedef double (*JacobiRowKernel)(double* out, const double* up,
+    const double* row, const double* down, int begin, int end,
+    const StencilWeights* weights);
+
+typedef double (*InplaceRowKernel)(const double* up, double* row,
+    const double* down, int begin, int end, const StencilWeights* weights);
+
+typedef double (*JacobiRow3DKernel)(double* out, const double* front,
+    const double* up, const double* row, const double* down,
+    const double* back, int begin, int end, const StencilWeights* weights);
+
+typedef double (*InplaceRow3DKernel)(const double* front, const double* up,
+    double* row, const double* down, const double* back, int begin, int end,
+    const StencilWeights* weights);
+
+typedef void (*FieldsJacobiRowKernel)(double* out, const double* up,
+    const double* row, const double* down, int begin, int end, int fields,
+    double* changes, const StencilWeights* weights);
+
+typedef void (*FieldsJacobiRow3DKernel)(double* out, const double* front,
+    const double* up, const double* row, const double* down,
+    const double* back, int begin, int end, int fields, double* changes,
+    const StencilWeights* weights);
+
+typedef double (*FixedJacobiKernel)(double* out, const double* in,
+    const StencilWeights* weights);
+
+typedef double (*FixedInplaceKernel)(double* grid,
+    const StencilWeights* weights);
+
+
+int prepareSolve(RelaxSolver* solver, size_t arenaBytes);
+
+void* solverAlloc(RelaxSolver* solver, size_t size);
+
+void initSolverRows(const RelaxSolver* solver, double* rows, int firstRow,
+    int lastRow);
+
+int reportProgress(RelaxSolver* solver, int iteration, double maxChange,
+    double skew);
+
+void beginTelemetry(RelaxSolver* solver);
+
+void endTelemetry(RelaxSolver* solver);
+
+int solveThreads(RelaxSolver* solver);
+
+int solveJacobi(RelaxSolver* solver);
+
+int solveWavefront(RelaxSolver* solver);
+
+int solveOutOfCore(RelaxSolver* solver);
+
+int solveDirect(RelaxSolver* solver);
+
+int solveChebyshev(RelaxSolver* solver);
+
+int solveFields(RelaxSolver* solver);
+
+int retireFields(FieldSet* set, double* fields, unsigned long cells,
+    unsigned long first, unsigned long count, const double* changes,
+    double precision, int iteration);
+
+double chebyshevBound(const RelaxSolver* solver);
+
+void startChebyshev(ChebyshevSchedule* schedule, const RelaxSolver* solver);
+
+void advanceChebyshev(ChebyshevSchedule* schedule, double maxChange);
+
+int countJacobiSweeps(const RelaxSolver* solver, bool fromGuess);
+
+void chebyshevRow(double* previous, const double* update, int columns,
+    double weight);
+
+double directDenominator(const RelaxSolver* solver, double vertical,
+    double horizontal);
+
+size_t directScratchSize(int interiorRows, int interiorColumns);
+
+void dstRows(const DstPlan* plan, double* rows, int first, int last,
+    double complex* scratch);
+
+void closeGridStore(RelaxSolver* solver);
+
+JacobiRowKernel selectJacobiRow(RelaxStencil stencil, int width);
+
+InplaceRowKernel selectInplaceRow(RelaxStencil stencil);
+
+JacobiRow3DKernel selectJacobiRow3D(RelaxStencil stencil);
+
+InplaceRow3DKernel selectInplaceRow3D(RelaxStencil stencil);
+
+FieldsJacobiRowKernel selectFieldsJacobiRow(RelaxStencil stencil, int fields);
+
+FieldsJacobiRow3DKernel selectFieldsJacobiRow3D(RelaxStencil stencil,
+    int fields);
+
+FixedJacobiKernel selectFixedJacobi(RelaxStencil stencil, int dimension);
+
+FixedInplaceKernel selectFixedInplace(RelaxStencil stencil, int dimension);
@@ -0,0 +1,221 @@
+/**
+ * @file relax_kernels.c
+ * @brief Source file instantiating the stencil engine (see stencil.h) for the
+ * solvers, and picking the kernel that matches a solve.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Every kernel is stamped out for each stencil shape. Jacobi row kernels are
+ * also specialised for common tile widths, multi-field row kernels for common
+ * numbers of fields, and whole-grid sweeps for a few small fixed grid sizes.
+ * Add a width, count or size to the lists below to specialise it too.
+ */
+
+#include <stddef.h>
+
+// The grids only ever hold finite values, so the kernels may assume there are
+// no NaNs. That is what lets the largest-change reductions vectorise. Neither
+// flag reorders arithmetic, so results are unchanged.
+#pragma GCC optimize ("tree-vectorize", "finite-math-only", "no-signed-zeros")
+
+#include "relax_internal.h"
+#include "stencil.h"
+
+
+// Tile widths with a specialised Jacobi row kernel. 0 is the generic kernel,
+// used for every other width.
+#define RELAX_TILE_WIDTHS(X) X(0) X(8) X(16) X(32) X(64)
+
+// Grid dimensions with a fully specialised sweep.
+#define RELAX_FIXED_SIZES(X) X(4) X(8) X(16) X(32) X(64)
+
+// Numbers of interleaved fields with a specialised multi-field kernel, whose
+// changes then stay in registers. 0 is the generic kernel, used for every
+// other number.
+#define RELAX_FIELD_COUNTS(X) X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8)
+
+
+// Instantiations, one per shape, in the order of RelaxStencil.
+#define DEFINE_JACOBI_ROWS(WIDTH) \
+    STENCIL_DEFINE_JACOBI_ROW(jacobiRow5x##WIDTH, double, STENCIL_5_POINT, \
+        WIDTH) \
+    STENCIL_DEFINE_JACOBI_ROW(jacobiRow9x##WIDTH, double, STENCIL_9_POINT, \
+        WIDTH) \
+    STENCIL_DEFINE_JACOBI_ROW(jacobiRowWeightedx##WIDTH, double, \
+        STENCIL_WEIGHTED, WIDTH)
+
+#define DEFINE_FIXED_SWEEPS(N) \
+    STENCIL_DEFINE_FIXED_JACOBI(fixedJacobi5x##N, double, STENCIL_5_POINT, N) \
+    STENCIL_DEFINE_FIXED_JACOBI(fixedJacobi9x##N, double, STENCIL_9_POINT, N) \
+    STENCIL_DEFINE_FIXED_JACOBI(fixedJacobiWeightedx##N, double, \
+        STENCIL_WEIGHTED, N) \
+    STENCIL_DEFINE_FIXED_INPLACE(fixedInplace5x##N, double, STENCIL_5_POINT, \
+        N) \
+    STENCIL_DEFINE_FIXED_INPLACE(fixedInplace9x##N, double, STENCIL_9_POINT, \
+        N) \
+    STENCIL_DEFINE_FIXED_INPLACE(fixedInplaceWeightedx##N, double, \
+        STENCIL_WEIGHTED, N)
+
+#define DEFINE_FIELDS_ROWS(FIELDS) \
+    STENCIL_DEFINE_FIELDS_JACOBI_ROW(fieldsRow5x##FIELDS, double, \
+        STENCIL_5_POINT, FIELDS) \
+    STENCIL_DEFINE_FIELDS_JACOBI_ROW(fieldsRow9x##FIELDS, double, \
+        STENCIL_9_POINT, FIELDS) \
+    STENCIL_DEFINE_FIELDS_JACOBI_ROW(fieldsRowWeightedx##FIELDS, double, \
+        STENCIL_WEIGHTED, FIELDS) \
+    STENCIL_DEFINE_FIELDS_JACOBI_ROW_3D(fieldsRow7x##FIELDS, double, \
+        STENCIL_7_POINT, FIELDS)
+
+RELAX_TILE_WIDTHS(DEFINE_JACOBI_ROWS)
+RELAX_FIXED_SIZES(DEFINE_FIXED_SWEEPS)
+RELAX_FIELD_COUNTS(DEFINE_FIELDS_ROWS)
+
+STENCIL_DEFINE_INPLACE_ROW(inplaceRow5, double, STENCIL_5_POINT)
+STENCIL_DEFINE_INPLACE_ROW(inplaceRow9, double, STENCIL_9_POINT)
+STENCIL_DEFINE_INPLACE_ROW(inplaceRowWeighted, double, STENCIL_WEIGHTED)
+
+STENCIL_DEFINE_JACOBI_ROW_3D(jacobiRow7, double, STENCIL_7_POINT, 0)
+STENCIL_DEFINE_INPLACE_ROW_3D(inplaceRow7, double, STENCIL_7_POINT)
+
+
+// Lookup tables.
+#define JACOBI_ROW_ENTRY(WIDTH) \
+    { WIDTH, { jacobiRow5x##WIDTH, jacobiRow9x##WIDTH, \
+    jacobiRowWeightedx##WIDTH } },
+
+#define FIXED_JACOBI_ENTRY(N) \
+    { N, { fixedJacobi5x##N, fixedJacobi9x##N, fixedJacobiWeightedx##N } },
+
+#define FIXED_INPLACE_ENTRY(N) \
+    { N, { fixedInplace5x##N, fixedInplace9x##N, fixedInplaceWeightedx##N } },
+
+#define FIELDS_ROW_ENTRY(FIELDS) \
+    { FIELDS, { fieldsRow5x##FIELDS, fieldsRow9x##FIELDS, \
+    fieldsRowWeightedx##FIELDS }, fieldsRow7x##FIELDS },
+
+static const struct
+{
+    int width;
+    JacobiRowKernel kernels[3];
+} jacobiRows[] = { RELAX_TILE_WIDTHS(JACOBI_ROW_ENTRY) };
+
+static const struct
+{
+    int fields;
+    FieldsJacobiRowKernel kernels[3];
+    FieldsJacobiRow3DKernel volume;
+} fieldsRows[] = { RELAX_FIELD_COUNTS(FIELDS_ROW_ENTRY) };
+
+static const struct
+{
+    int dimension;
+    FixedJacobiKernel kernels[3];
+} fixedJacobis[] = { RELAX_FIXED_SIZES(FIXED_JACOBI_ENTRY) };
+
+static const struct
+{
+    int dimension;
+    FixedInplaceKernel kernels[3];
+} fixedInplaces[] = { RELAX_FIXED_SIZES(FIXED_INPLACE_ENTRY) };
+
+static const InplaceRowKernel inplaceRows[3] =
+{
+    inplaceRow5, inplaceRow9, inplaceRowWeighted
+};
+
+
+// Returns the Jacobi row kernel for the stencil, specialised for the tile
+// width if there is one.
+JacobiRowKernel selectJacobiRow(RelaxStencil stencil, int width)
+{
+    int entries = (int) (sizeof(jacobiRows) / sizeof(jacobiRows[0]));
+    for (int i = 1; i < entries; i++)
+    {
+        if (jacobiRows[i].width == width)
+        {
+            return jacobiRows[i].kernels[stencil];
+        }
+    }
+    return jacobiRows[0].kernels[stencil];
+}
+
+InplaceRowKernel selectInplaceRow(RelaxStencil stencil)
+{
+    return inplaceRows[stencil];
+}
+
+// Volumes only have the nearest neighbour stencil. Returns NULL for the others.
+JacobiRow3DKernel selectJacobiRow3D(RelaxStencil stencil)
+{
+    return stencil == RELAX_STENCIL_5_POINT ? jacobiRow7 : NULL;
+}
+
+InplaceRow3DKernel selectInplaceRow3D(RelaxStencil stencil)
+{
+    return stencil == RELAX_STENCIL_5_POINT ? inplaceRow7 : NULL;
+}
+
+// Returns the multi-field Jacobi row kernel for the stencil, specialised for
+// the number of fields if there is one.
+FieldsJacobiRowKernel selectFieldsJacobiRow(RelaxStencil stencil, int fields)
+{
+    int entries = (int) (sizeof(fieldsRows) / sizeof(fieldsRows[0]));
+    for (int i = 1; i < entries; i++)
+    {
+        if (fieldsRows[i].fields == fields)
+        {
+            return fieldsRows[i].kernels[stencil];
+        }
+    }
+    return fieldsRows[0].kernels[stencil];
+}
+
+// As selectFieldsJacobiRow, for volumes. Returns NULL for the stencils volumes
+// do not have.
+FieldsJacobiRow3DKernel selectFieldsJacobiRow3D(RelaxStencil stencil,
+    int fields)
+{
+    if (stencil != RELAX_STENCIL_5_POINT)
+    {
+        return NULL;
+    }
+    int entries = (int) (sizeof(fieldsRows) / sizeof(fieldsRows[0]));
+    for (int i = 1; i < entries; i++)
+    {
+        if (fieldsRows[i].fields == fields)
+        {
+            return fieldsRows[i].volume;
+        }
+    }
+    return fieldsRows[0].volume;
+}
+
+// Returns the fixed-size Jacobi sweep for the grid, or NULL if its size has
+// none.
+FixedJacobiKernel selectFixedJacobi(RelaxStencil stencil, int dimension)
+{
+    int entries = (int) (sizeof(fixedJacobis) / sizeof(fixedJacobis[0]));
+    for (int i = 0; i < entries; i++)
+    {
+        if (fixedJacobis[i].dimension == dimension)
+        {
+            return fixedJacobis[i].kernels[stencil];
+        }
+    }
+    return NULL;
+}
+
+// Returns the fixed-size in-place sweep for the grid, or NULL if its size has
+// none.
+FixedInplaceKernel selectFixedInplace(RelaxStencil stencil, int dimension)
+{
+    int entries = (int) (sizeof(fixedInplaces) / sizeof(fixedInplaces[0]));
+    for (int i = 0; i < entries; i++)
+    {
+        if (fixedInplaces[i].dimension == dimension)
+        {
+            return fixedInplaces[i].kernels[stencil];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,1154 @@
+/**
+ * @file relax_mpi.c
+ * @brief Source file for the distributed memory method: Jacobi relaxation over
+ * slabs of rows (or of planes, for volumes), one slab per MPI rank.
+ * @date 29/12/2021
+ * @author dancs-dev
+ *
+ * The interior rows (planes, for volumes) are split evenly between the ranks,
+ * and there must be at least one per rank. Optionally, the split is rebalanced
+ * every few sweeps: each rank times its sweeps, and neighbouring ranks move
+ * layers across their shared edge until they take equally long, so a slow or
+ * busy node no longer sets the pace for all of them.
+ *
+ * With RELAX_METHOD_CHEBYSHEV, each rank also keeps its slab from the sweep
+ * before, and extrapolates from it along every Jacobi update (see
+ * relax_chebyshev.c). The weights only depend on the global change, which
+ * every rank already has, so the ranks need no extra communication.
+ *
+ * A multi-field solve (see relax_fields.c) interleaves its fields in every
+ * layer, so each halo exchange carries all the fields still relaxing in one
+ * message.
+ *
+ * With RELAX_METHOD_DIRECT, the ranks instead solve the grid exactly with
+ * discrete sine transforms (see relax_direct.c). Each rank transforms a band of
+ * rows; an all-to-all transpose then hands every rank a band of columns to
+ * transform, and a second one hands the rows back.
+ */
+
+#include <mpi.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+#include "relax_mpi.h"
+
+
+// Slabs of every rank, which each rank tracks identically.
+typedef struct
+{
+    // Rank i owns layers partition[i] to partition[i + 1] - 1.
+    int* partition;
+    // Largest slab the buffers of a rank can hold, in layers.
+    int capacity;
+    int layerSize;
+    // Slab of this rank with a halo layer either side, and its scratch copy.
+    double* buffer;
+    double* copy;
+    // The slab one sweep earlier, laid out like the buffer, for the Chebyshev
+    // method. NULL otherwise.
+    double* previous;
+} SlabLayout;
+
+
+// Function declarations
+static void exchangeHalos(double* slab, int layers, int layerSize,
+    int world_rank, int world_size, MPI_Comm comm);
+static int solveFieldsDistributed(RelaxSolver* solver, int world_rank,
+    int world_size, MPI_Comm comm);
+static void rebalanceSlabs(SlabLayout* slabs, const double* sweepTimes,
+    int world_rank, int world_size, MPI_Comm comm);
+static void migrateLayers(SlabLayout* slabs, double** slab, int oldFirst,
+    int oldLast, int world_rank, MPI_Comm comm);
+static void chebyshevLayer(double* previous, const double* update,
+    const GridExtents* extents, bool volume, double weight);
+static double relaxPlane(double* plane, const double* copy,
+    const GridExtents* extents, JacobiRow3DKernel relaxRow,
+    const StencilWeights* weights);
+static int solveDirectDistributed(RelaxSolver* solver, int world_rank,
+    int world_size, MPI_Comm comm);
+static void transposeDistributed(const double* in, double* out, int inRows,
+    int outRows, const int* outStarts, const int* inStarts, int world_size,
+    double* sendBuffer, double* recvBuffer, int* counts, MPI_Comm comm);
+static int pinRank(RelaxSolver* solver, int world_rank, MPI_Comm comm);
+
+
+int relaxSetRebalance(RelaxSolver* solver, int interval)
+{
+    if (interval < 0)
+    {
+        return RELAX_ERROR;
+    }
+    solver->rebalanceInterval = interval;
+    return RELAX_OK;
+}
+
+int relaxSolveDistributed(RelaxSolver* solver, MPI_Comm comm)
+{
+    const GridExtents* extents = &solver->extents;
+    double PRECISION = solver->precision;
+    int ok;
+
+    atomic_store(&solver->cancelled, 0);
+    solver->iterations = 0;
+    solver->chebyshevConverged = false;
+
+    // The slabs are layers along the outer axis: the rows of a grid, or the
+    // planes of a volume. Halos are therefore whole rows or whole planes, and
+    // "rows" below means layers.
+    bool volume = (extents->planes > 1);
+    int LAYERS = volume ? extents->planes : extents->rows;
+    int LAYER_SIZE = extents->columns * (volume ? extents->rows : 1);
+    // Rows of the stack of rows (see GridExtents) in a layer.
+    int LAYER_ROWS = volume ? extents->rows : 1;
+
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, 0);
+    JacobiRow3DKernel relaxVolumeRow = selectJacobiRow3D(solver->stencil);
+    if (volume && relaxVolumeRow == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    // Get the number of processes
+    int world_size;
+    ok = MPI_Comm_size(comm, &world_size);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error getting world size.\n");
+        MPI_Abort(comm, ok);
+    }
+
+    // Get the rank of the process
+    int world_rank;
+    ok = MPI_Comm_rank(comm, &world_rank);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error getting world rank.\n");
+        MPI_Abort(comm, ok);
+    }
+
+    if (solver->fieldCount > 0)
+    {
+        // Several fields are only relaxed by plain Jacobi sweeps, over a
+        // fixed split.
+        if (solver->method == RELAX_METHOD_DIRECT ||
+            solver->method == RELAX_METHOD_CHEBYSHEV ||
+            solver->rebalanceInterval > 0)
+        {
+            return RELAX_ERROR;
+        }
+        return solveFieldsDistributed(solver, world_rank, world_size, comm);
+    }
+
+    if (solver->method == RELAX_METHOD_DIRECT)
+    {
+        return solveDirectDistributed(solver, world_rank, world_size, comm);
+    }
+
+    // Every rank needs at least one interior layer. All ranks see the same
+    // extents, so they all give up together.
+    if (LAYERS - 2 < world_size)
+    {
+        return RELAX_ERROR;
+    }
+
+    // Only the root reports progress, so only it streams telemetry.
+    if (world_rank == 0)
+    {
+        beginTelemetry(solver);
+    }
+
+    // Pin before anything is allocated, so every buffer this rank creates is
+    // first touched from the CPU (and NUMA node) it will run on.
+    int cpu = pinRank(solver, world_rank, comm);
+
+    // Layers 0 and LAYERS - 1 are boundaries. The interior layers are split
+    // evenly, the first INTERIOR % world_size ranks taking one extra, and every
+    // rank keeps a halo layer either side of its own. The halos of the first and
+    // last rank are the boundary layers themselves, which never change.
+    // partition[i] is the first layer of rank i, and partition[world_size] is
+    // the last boundary layer, so each rank owns partition[i] to
+    // partition[i + 1] - 1.
+    int INTERIOR = LAYERS - 2;
+    int evenShare = (INTERIOR + world_size - 1) / world_size;
+
+    // With rebalancing, a slab may grow to twice the even share (or to all the
+    // layers the other ranks can spare), so its buffers are sized for that.
+    int capacity = evenShare;
+    if (solver->rebalanceInterval > 0)
+    {
+        capacity = 2 * evenShare;
+        if (capacity > INTERIOR - (world_size - 1))
+        {
+            capacity = INTERIOR - (world_size - 1);
+        }
+    }
+
+    // Every buffer of this rank comes from one huge page backed arena. Only the
+    // root needs the whole grid, to gather into.
+    unsigned long maxSlabElems = (unsigned long) (capacity + 2) *
+        (unsigned long) LAYER_SIZE;
+    bool chebyshev = (solver->method == RELAX_METHOD_CHEBYSHEV);
+    size_t arenaBytes = (arenaSizeFor(sizeof(double) * maxSlabElems) *
+        (chebyshev ? 3 : 2)) +
+        arenaSizeFor(sizeof(int) * (unsigned long) (world_size + 1)) +
+        (arenaSizeFor(sizeof(int) * (unsigned long) world_size) * 2) +
+        arenaSizeFor(sizeof(double) * (unsigned long) world_size) +
+        arenaSizeFor(sizeof(WorkerPlacement));
+    if (world_rank == 0)
+    {
+        arenaBytes += doubleMatrixArenaSize(extents);
+    }
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        printf("Error creating arena.\n");
+        MPI_Abort(comm, -1);
+    }
+
+    SlabLayout slabs;
+    slabs.capacity = capacity;
+    slabs.layerSize = LAYER_SIZE;
+    slabs.partition = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) (world_size + 1));
+    for (int i = 0; i <= world_size; i++)
+    {
+        slabs.partition[i] = 1 + (int) ((long) i * INTERIOR / world_size);
+    }
+
+    // Used to gather the slabs at the end, once their final size is known.
+    int* recvCounts = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    int* recvDisplacements = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    double* sweepTimes = (double*) solverAlloc(solver, sizeof(double) *
+        (unsigned long) world_size);
+
+    // Only the root keeps the whole grid, which the slabs are gathered into at
+    // the end. Every rank initialises its own slab (halo layers included)
+    // directly, so nothing needs replicating or distributing up front.
+    if (world_rank == 0)
+    {
+        solver->grid = createDoubleMatrix(solver->arena, extents);
+        if (solver->grid == NULL)
+        {
+            MPI_Abort(comm, -1);
+        }
+        initDoubleMatrixRows(solver->grid, extents, 0,
+            extents->rows * extents->planes, &solver->boundaries);
+    }
+
+    // The buffer holds the slab and its halo layers. The copy is the last sweep
+    // the slab is relaxed from, and doubles as scratch space when rebalancing.
+    slabs.buffer = (double*) solverAlloc(solver, sizeof(double) *
+        maxSlabElems);
+    slabs.copy = (double*) solverAlloc(solver, sizeof(double) * maxSlabElems);
+    slabs.previous = NULL;
+    if (chebyshev)
+    {
+        slabs.previous = (double*) solverAlloc(solver, sizeof(double) *
+            maxSlabElems);
+    }
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement));
+    if (slabs.partition == NULL || recvCounts == NULL ||
+        recvDisplacements == NULL || sweepTimes == NULL ||
+        slabs.buffer == NULL || slabs.copy == NULL ||
+        (chebyshev && slabs.previous == NULL) || solver->placements == NULL)
+    {
+        MPI_Abort(comm, -1);
+    }
+
+    // Initialise buffer with correct values.
+    int firstLayer = slabs.partition[world_rank];
+    int numRowsPerProc = slabs.partition[world_rank + 1] - firstLayer;
+    initDoubleMatrixRows(slabs.buffer, extents,
+        (firstLayer - 1) * LAYER_ROWS,
+        (firstLayer + numRowsPerProc + 1) * LAYER_ROWS, &solver->boundaries);
+    if (chebyshev)
+    {
+        memcpy(slabs.previous, slabs.buffer, sizeof(double) *
+            (unsigned long) ((numRowsPerProc + 2) * LAYER_SIZE));
+    }
+
+    // Every rank follows the same Chebyshev schedule from the same global
+    // changes.
+    ChebyshevSchedule schedule;
+    startChebyshev(&schedule, solver);
+
+    // Set by the root when the progress callback asks to stop, and shared with
+    // the other ranks in the next reduction.
+    double cancel = 0.0;
+
+    // Seconds this rank has spent relaxing since the slabs were last balanced.
+    // Communication is left out, as waiting for a slow neighbour is exactly
+    // what rebalancing should remove.
+    double busy = 0.0;
+
+    while(true)
+    {
+        double* doubleMatrixBuffer = slabs.buffer;
+        double* doubleMatrixBufferCopy = slabs.copy;
+
+        // Distribute sections of double matrix to all processors.
+        exchangeHalos(doubleMatrixBuffer, numRowsPerProc, LAYER_SIZE,
+            world_rank, world_size, comm);
+
+        // Copy to double matrix buffer copy. This is so we can relax the matrix
+        // using averages calculated from double matrix buffer copy, and store
+        // the relaxed iteration in double matrix buffer.
+        memcpy(doubleMatrixBufferCopy, doubleMatrixBuffer, sizeof(double) *
+            (unsigned long) ((numRowsPerProc + 2) * LAYER_SIZE));
+
+        // Largest change of any cell this rank relaxes. The slab is balanced
+        // if it is within precision.
+        double maxChange = 0.0;
+        double started = MPI_Wtime();
+        double weight = schedule.weight;
+
+        // Each proc loops through their buffer, starting with rows that they
+        // are responsible for averaging. Remember, numRowsPerProc corresponds
+        // to the raw number of rows they are working on, not including the
+        // halo rows either side.
+        for(int i = 1; i < numRowsPerProc + 1; i++)
+        {
+            // Relax between 1 and second from last element of each row. As
+            // before, we do not edit the outer elements of the array. Averages
+            // are calculated from double matrix buffer copy, to maintain the
+            // integrity of the sweep.
+            double change;
+            if (volume)
+            {
+                change = relaxPlane(doubleMatrixBuffer + (i * LAYER_SIZE),
+                    doubleMatrixBufferCopy + (i * LAYER_SIZE), extents,
+                    relaxVolumeRow, &solver->weights);
+            }
+            else
+            {
+                double* row = doubleMatrixBufferCopy + (i * LAYER_SIZE);
+                change = relaxRow(doubleMatrixBuffer + (i * LAYER_SIZE),
+                    row - LAYER_SIZE, row, row + LAYER_SIZE, 1,
+                    extents->columns - 1, &solver->weights);
+            }
+            maxChange = fmax(maxChange, change);
+
+            // The buffer holds the Jacobi update. Extrapolate the previous
+            // slab along it, into the next.
+            if (chebyshev)
+            {
+                chebyshevLayer(slabs.previous + (i * LAYER_SIZE),
+                    doubleMatrixBuffer + (i * LAYER_SIZE), extents, volume,
+                    weight);
+            }
+        }
+
+        // The previous slab now holds the next sweep, and the copy the one
+        // before it. The buffer is free to be the next copy.
+        if (chebyshev)
+        {
+            slabs.buffer = slabs.previous;
+            slabs.previous = doubleMatrixBufferCopy;
+            slabs.copy = doubleMatrixBuffer;
+        }
+
+        // One reduction both decides whether every slab is balanced and gives
+        // the root the global change to report. It replaces gathering a flag
+        // from every processor and broadcasting the verdict. It also finds the
+        // slowest and (negated) fastest sweep, for the skew, at no extra cost.
+        double sweepTime = MPI_Wtime() - started;
+        double local[4] = { maxChange, cancel, sweepTime, -sweepTime };
+        double global[4];
+        ok = MPI_Allreduce(local, global, 4, MPI_DOUBLE, MPI_MAX, comm);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error reducing precision reached status.\n");
+            MPI_Abort(comm, ok);
+        }
+        busy += sweepTime;
+        solver->iterations++;
+        advanceChebyshev(&schedule, global[0]);
+
+        if (global[1] != 0.0)
+        {
+            atomic_store(&solver->cancelled, 1);
+            break;
+        }
+        if (world_rank == 0 && reportProgress(solver, solver->iterations,
+            global[0], global[2] + global[3]) != 0)
+        {
+            cancel = 1.0;
+        }
+
+        if (global[0] <= PRECISION) break;
+
+        if (solver->rebalanceInterval > 0 &&
+            solver->iterations % solver->rebalanceInterval == 0)
+        {
+            ok = MPI_Allgather(&busy, 1, MPI_DOUBLE, sweepTimes, 1,
+                MPI_DOUBLE, comm);
+            if (ok != MPI_SUCCESS)
+            {
+                printf("Error gathering sweep times.\n");
+                MPI_Abort(comm, ok);
+            }
+            rebalanceSlabs(&slabs, sweepTimes, world_rank, world_size, comm);
+            // The previous slab follows the same edges.
+            if (chebyshev)
+            {
+                migrateLayers(&slabs, &slabs.previous, firstLayer,
+                    firstLayer + numRowsPerProc, world_rank, comm);
+            }
+            firstLayer = slabs.partition[world_rank];
+            numRowsPerProc = slabs.partition[world_rank + 1] - firstLayer;
+            busy = 0.0;
+        }
+    }
+
+    // The distributed solve has no initial guess.
+    solver->chebyshevConverged = chebyshev &&
+        !atomic_load(&solver->cancelled);
+    solver->chebyshevFromGuess = false;
+
+    // The placement is in layers: rows, or planes for volumes.
+    solver->placementCount = 1;
+    solver->placements[0].cpu = cpu;
+    solver->placements[0].firstRow = firstLayer;
+    solver->placements[0].lastRow = firstLayer + numRowsPerProc - 1;
+
+    for (int i = 0; i < world_size; i++)
+    {
+        recvCounts[i] = (slabs.partition[i + 1] - slabs.partition[i]) *
+            LAYER_SIZE;
+        recvDisplacements[i] = slabs.partition[i] * LAYER_SIZE;
+    }
+
+    // Gather and update root double matrix with relaxed values from each proc.
+    ok = MPI_Gatherv(slabs.buffer + LAYER_SIZE,
+        recvCounts[world_rank], MPI_DOUBLE, solver->grid, recvCounts,
+        recvDisplacements, MPI_DOUBLE, 0, comm);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error gathering solution.\n");
+        MPI_Abort(comm, ok);
+    }
+
+    if (world_rank == 0)
+    {
+        endTelemetry(solver);
+    }
+    return atomic_load(&solver->cancelled) ? RELAX_CANCELLED : RELAX_OK;
+}
+
+// Swaps halo layers with the neighbouring ranks: the first and last layers of
+// the slab go out, and the neighbours' edge layers come back into the halos.
+// slab starts at the halo layer before the slab, which holds layers layers of
+// layerSize values.
+static void exchangeHalos(double* slab, int layers, int layerSize,
+    int world_rank, int world_size, MPI_Comm comm)
+{
+    int ok;
+
+    // Send prior rows.
+    if (world_rank > 0)
+    {
+        ok = MPI_Send(slab + layerSize, layerSize, MPI_DOUBLE, world_rank - 1,
+            0, comm);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error sending start rows to below processors.\n");
+            MPI_Abort(comm, ok);
+        }
+    }
+
+    // Receive ending rows
+    if (world_rank < world_size - 1)
+    {
+        MPI_Status stat;
+        ok = MPI_Recv(slab + ((long) (layers + 1) * layerSize), layerSize,
+            MPI_DOUBLE, world_rank + 1, 0, comm, &stat);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error receiving start rows from above processors.\n");
+            MPI_Abort(comm, ok);
+        }
+    }
+
+    // Minus 1 as proc count starts at 0.
+    // Send ending rows
+    if (world_rank < world_size - 1)
+    {
+        ok = MPI_Send(slab + ((long) layers * layerSize), layerSize,
+            MPI_DOUBLE, world_rank + 1, 1, comm);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error sending end rows to above processors.\n");
+            MPI_Abort(comm, ok);
+        }
+    }
+
+    // Receive prior rows
+    if (world_rank > 0)
+    {
+        MPI_Status stat;
+        ok = MPI_Recv(slab, layerSize, MPI_DOUBLE, world_rank - 1, 1, comm,
+            &stat);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error receiving end rows from below processors.\n");
+            MPI_Abort(comm, ok);
+        }
+    }
+}
+
+// Relaxes every field of a multi-field solve with Jacobi sweeps over an even,
+// fixed split of the layers (see relax_fields.c). Each halo carries all the
+// active fields of its layer, and the reduction every sweep carries the change
+// of each field, so every rank retires the same fields after the same sweep.
+// Each rank keeps the retired fields of its own layers until the end, when
+// they are gathered field by field on the root.
+static int solveFieldsDistributed(RelaxSolver* solver, int world_rank,
+    int world_size, MPI_Comm comm)
+{
+    const GridExtents* extents = &solver->extents;
+    int fields = solver->fieldCount;
+    bool volume = (extents->planes > 1);
+    int LAYERS = volume ? extents->planes : extents->rows;
+    int LAYER_SIZE = extents->columns * (volume ? extents->rows : 1);
+    int LAYER_ROWS = volume ? extents->rows : 1;
+    int ok;
+
+    if ((volume && selectFieldsJacobiRow3D(solver->stencil, 0) == NULL) ||
+        LAYERS - 2 < world_size)
+    {
+        return RELAX_ERROR;
+    }
+
+    if (world_rank == 0)
+    {
+        beginTelemetry(solver);
+    }
+    int cpu = pinRank(solver, world_rank, comm);
+
+    int INTERIOR = LAYERS - 2;
+    int firstLayer = 1 + (int) ((long) world_rank * INTERIOR / world_size);
+    int layers = 1 + (int) ((long) (world_rank + 1) * INTERIOR / world_size) -
+        firstLayer;
+
+    unsigned long slabElems = (unsigned long) (layers + 2) *
+        (unsigned long) LAYER_SIZE * (unsigned long) fields;
+    unsigned long ownElems = (unsigned long) layers *
+        (unsigned long) LAYER_SIZE * (unsigned long) fields;
+    size_t arenaBytes = (arenaSizeFor(sizeof(double) * slabElems) * 2) +
+        arenaSizeFor(sizeof(double) * ownElems) +
+        (arenaSizeFor(sizeof(int) * (unsigned long) fields) * 2) +
+        (arenaSizeFor(sizeof(double) * (unsigned long) (fields + 3)) * 2) +
+        (arenaSizeFor(sizeof(int) * (unsigned long) world_size) * 2) +
+        arenaSizeFor(sizeof(WorkerPlacement));
+    if (world_rank == 0)
+    {
+        arenaBytes += fieldsMatrixArenaSize(extents, fields);
+    }
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        printf("Error creating arena.\n");
+        MPI_Abort(comm, -1);
+    }
+
+    double* buffer = (double*) solverAlloc(solver, sizeof(double) * slabElems);
+    double* next = (double*) solverAlloc(solver, sizeof(double) * slabElems);
+    FieldSet set;
+    set.active = fields;
+    set.lanes = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) fields);
+    set.results = (double*) solverAlloc(solver, sizeof(double) * ownElems);
+    set.resultCells = (unsigned long) layers * (unsigned long) LAYER_SIZE;
+    set.iterations = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) fields);
+    // The changes of the active fields, then the cancel flag and the sweep
+    // time, as in the single field reduction.
+    double* local = (double*) solverAlloc(solver, sizeof(double) *
+        (unsigned long) (fields + 3));
+    double* global = (double*) solverAlloc(solver, sizeof(double) *
+        (unsigned long) (fields + 3));
+    int* recvCounts = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    int* recvDisplacements = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement));
+    if (buffer == NULL || next == NULL || set.lanes == NULL ||
+        set.results == NULL || set.iterations == NULL || local == NULL ||
+        global == NULL || recvCounts == NULL || recvDisplacements == NULL ||
+        solver->placements == NULL)
+    {
+        MPI_Abort(comm, -1);
+    }
+    for (int f = 0; f < fields; f++)
+    {
+        set.lanes[f] = f;
+        set.iterations[f] = 0;
+    }
+
+    // The root gathers every field's grid in turn, boundaries included.
+    unsigned long cells = gridCells(extents);
+    if (world_rank == 0)
+    {
+        solver->grid = createFieldsMatrix(solver->arena, extents, fields);
+        if (solver->grid == NULL)
+        {
+            MPI_Abort(comm, -1);
+        }
+        for (int f = 0; f < fields; f++)
+        {
+            initDoubleMatrixRows(solver->grid + ((unsigned long) f * cells),
+                extents, 0, extents->rows * extents->planes,
+                &solver->fieldBoundaries[f]);
+        }
+    }
+    solver->resultFields = fields;
+    solver->fieldIterations = set.iterations;
+
+    initFieldsMatrixRows(buffer, extents, (firstLayer - 1) * LAYER_ROWS,
+        (firstLayer + layers + 1) * LAYER_ROWS, solver->fieldBoundaries,
+        fields);
+    // As in solveFields, the two slabs take turns to hold the last sweep. The
+    // halos of both are refreshed before they are read.
+    memcpy(next, buffer, sizeof(double) * slabElems);
+
+    double cancel = 0.0;
+    while (set.active > 0)
+    {
+        int active = set.active;
+        int layerLength = LAYER_SIZE * active;
+        long rowLength = (long) extents->columns * active;
+
+        exchangeHalos(buffer, layers, layerLength, world_rank, world_size,
+            comm);
+
+        for (int f = 0; f < active; f++)
+        {
+            local[f] = 0.0;
+        }
+        double started = MPI_Wtime();
+        FieldsJacobiRowKernel relaxRow = selectFieldsJacobiRow(
+            solver->stencil, active);
+        FieldsJacobiRow3DKernel relaxVolumeRow = selectFieldsJacobiRow3D(
+            solver->stencil, active);
+        for (int i = 1; i < layers + 1; i++)
+        {
+            long offset = (long) i * layerLength;
+            if (!volume)
+            {
+                const double* row = buffer + offset;
+                relaxRow(next + offset, row - rowLength, row,
+                    row + rowLength, 1, extents->columns - 1, active, local,
+                    &solver->weights);
+                continue;
+            }
+            for (int x = 1; x < extents->rows - 1; x++)
+            {
+                const double* row = buffer + offset + (x * rowLength);
+                relaxVolumeRow(next + offset + (x * rowLength),
+                    row - layerLength, row - rowLength, row, row + rowLength,
+                    row + layerLength, 1, extents->columns - 1, active, local,
+                    &solver->weights);
+            }
+        }
+
+        double sweepTime = MPI_Wtime() - started;
+        double* last = buffer;
+        buffer = next;
+        next = last;
+        local[active] = cancel;
+        local[active + 1] = sweepTime;
+        local[active + 2] = -sweepTime;
+        ok = MPI_Allreduce(local, global, active + 3, MPI_DOUBLE, MPI_MAX,
+            comm);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error reducing precision reached status.\n");
+            MPI_Abort(comm, ok);
+        }
+        solver->iterations++;
+
+        double maxChange = 0.0;
+        for (int f = 0; f < active; f++)
+        {
+            maxChange = fmax(maxChange, global[f]);
+        }
+        // A cancelled solve leaves every field where it got to.
+        if (global[active] != 0.0)
+        {
+            atomic_store(&solver->cancelled, 1);
+            retireFields(&set, buffer, (unsigned long) (layers + 2) *
+                (unsigned long) LAYER_SIZE, (unsigned long) LAYER_SIZE,
+                set.resultCells, global, HUGE_VAL, solver->iterations);
+            break;
+        }
+        if (world_rank == 0 && reportProgress(solver, solver->iterations,
+            maxChange, global[active + 1] + global[active + 2]) != 0)
+        {
+            cancel = 1.0;
+        }
+        if (retireFields(&set, buffer, (unsigned long) (layers + 2) *
+            (unsigned long) LAYER_SIZE, (unsigned long) LAYER_SIZE,
+            set.resultCells, global, solver->precision, solver->iterations) <
+            active)
+        {
+            memcpy(next, buffer, sizeof(double) * (unsigned long) (layers + 2) *
+                (unsigned long) LAYER_SIZE * (unsigned long) set.active);
+        }
+    }
+
+    solver->placementCount = 1;
+    solver->placements[0].cpu = cpu;
+    solver->placements[0].firstRow = firstLayer;
+    solver->placements[0].lastRow = firstLayer + layers - 1;
+
+    for (int i = 0; i < world_size; i++)
+    {
+        int first = 1 + (int) ((long) i * INTERIOR / world_size);
+        int last = 1 + (int) ((long) (i + 1) * INTERIOR / world_size);
+        recvCounts[i] = (last - first) * LAYER_SIZE;
+        recvDisplacements[i] = first * LAYER_SIZE;
+    }
+    for (int f = 0; f < fields; f++)
+    {
+        ok = MPI_Gatherv(set.results + ((unsigned long) f * set.resultCells),
+            recvCounts[world_rank], MPI_DOUBLE, world_rank == 0 ?
+            solver->grid + ((unsigned long) f * cells) : NULL, recvCounts,
+            recvDisplacements, MPI_DOUBLE, 0, comm);
+        if (ok != MPI_SUCCESS)
+        {
+            printf("Error gathering solution.\n");
+            MPI_Abort(comm, ok);
+        }
+    }
+
+    if (world_rank == 0)
+    {
+        endTelemetry(solver);
+    }
+    return atomic_load(&solver->cancelled) ? RELAX_CANCELLED : RELAX_OK;
+}
+
+// Moves the edges between neighbouring slabs so they take equally long to
+// relax, going by the time each rank spent relaxing since the last rebalance.
+// Every rank computes the same new partition from the same times, then swaps
+// the layers that changed hands with its neighbours.
+static void rebalanceSlabs(SlabLayout* slabs, const double* sweepTimes,
+    int world_rank, int world_size, MPI_Comm comm)
+{
+    int* partition = slabs->partition;
+    int oldFirst = partition[world_rank];
+    int oldLast = partition[world_rank + 1];
+
+    // Every edge is moved from the old sizes, so all edges move at once. Each
+    // rank gives at most half its layers (less one) across either edge, and
+    // takes at most half its spare capacity across either edge, so every slab
+    // keeps at least one layer, fits its buffers, and only trades layers with
+    // its neighbours.
+    int previousEdge = partition[0];
+    for (int i = 1; i < world_size; i++)
+    {
+        int below = partition[i] - previousEdge;
+        int above = partition[i + 1] - partition[i];
+        previousEdge = partition[i];
+        double belowTime = sweepTimes[i - 1];
+        double aboveTime = sweepTimes[i];
+        double perLayer = (belowTime / below) + (aboveTime / above);
+        if (perLayer <= 0.0)
+        {
+            continue;
+        }
+
+        // Layers to hand from rank i - 1 to rank i (negative for the other
+        // way) so that both take the same time. Rounding towards zero leaves
+        // slabs within a layer of balance where they are, so they settle.
+        int moved = (int) trunc((belowTime - aboveTime) / perLayer);
+        int maxUp = (below - 1) / 2;
+        if ((slabs->capacity - above) / 2 < maxUp)
+        {
+            maxUp = (slabs->capacity - above) / 2;
+        }
+        int maxDown = (above - 1) / 2;
+        if ((slabs->capacity - below) / 2 < maxDown)
+        {
+            maxDown = (slabs->capacity - below) / 2;
+        }
+        if (moved > maxUp)
+        {
+            moved = maxUp;
+        }
+        if (moved < -maxDown)
+        {
+            moved = -maxDown;
+        }
+        partition[i] -= moved;
+    }
+
+    migrateLayers(slabs, &slabs->buffer, oldFirst, oldLast, world_rank, comm);
+}
+
+// Builds the new slab of this rank in the copy buffer, from the layers it keeps
+// (and its old halos, which hold the boundaries at either end of the grid) and
+// the layers it receives, then swaps it with slab (the buffer, or the previous
+// slab). The copy is rewritten before the next sweep anyway.
+static void migrateLayers(SlabLayout* slabs, double** slab, int oldFirst,
+    int oldLast, int world_rank, MPI_Comm comm)
+{
+    int layerSize = slabs->layerSize;
+    int newFirst = slabs->partition[world_rank];
+    int newLast = slabs->partition[world_rank + 1];
+    // Buffers start at the halo layer before the slab.
+    double* oldSlab = *slab - ((long) (oldFirst - 1) * layerSize);
+    double* newSlab = slabs->copy - ((long) (newFirst - 1) * layerSize);
+
+    int keepFirst = (newFirst > oldFirst) ? newFirst - 1 : oldFirst - 1;
+    int keepLast = (newLast < oldLast) ? newLast + 1 : oldLast + 1;
+    if (keepFirst < keepLast)
+    {
+        memcpy(newSlab + ((long) keepFirst * layerSize),
+            oldSlab + ((long) keepFirst * layerSize), sizeof(double) *
+            (unsigned long) ((keepLast - keepFirst) * layerSize));
+    }
+
+    // At most one send or receive across each edge.
+    MPI_Request requests[2];
+    int count = 0;
+    int ok = MPI_SUCCESS;
+    if (newFirst < oldFirst)
+    {
+        ok |= MPI_Irecv(newSlab + ((long) newFirst * layerSize),
+            (oldFirst - newFirst) * layerSize, MPI_DOUBLE, world_rank - 1, 2,
+            comm, &requests[count++]);
+    }
+    else if (newFirst > oldFirst)
+    {
+        ok |= MPI_Isend(oldSlab + ((long) oldFirst * layerSize),
+            (newFirst - oldFirst) * layerSize, MPI_DOUBLE, world_rank - 1, 3,
+            comm, &requests[count++]);
+    }
+    if (newLast > oldLast)
+    {
+        ok |= MPI_Irecv(newSlab + ((long) oldLast * layerSize),
+            (newLast - oldLast) * layerSize, MPI_DOUBLE, world_rank + 1, 3,
+            comm, &requests[count++]);
+    }
+    else if (newLast < oldLast)
+    {
+        ok |= MPI_Isend(oldSlab + ((long) newLast * layerSize),
+            (oldLast - newLast) * layerSize, MPI_DOUBLE, world_rank + 1, 2,
+            comm, &requests[count++]);
+    }
+    if (ok != MPI_SUCCESS ||
+        MPI_Waitall(count, requests, MPI_STATUSES_IGNORE) != MPI_SUCCESS)
+    {
+        printf("Error migrating rows between processors.\n");
+        MPI_Abort(comm, -1);
+    }
+
+    double* old = *slab;
+    *slab = slabs->copy;
+    slabs->copy = old;
+}
+
+// Runs chebyshevRow over the interior rows of a layer: a row, or a plane.
+static void chebyshevLayer(double* previous, const double* update,
+    const GridExtents* extents, bool volume, double weight)
+{
+    int columns = extents->columns;
+    if (!volume)
+    {
+        chebyshevRow(previous, update, columns, weight);
+        return;
+    }
+    for (int x = 1; x < extents->rows - 1; x++)
+    {
+        chebyshevRow(previous + ((long) x * columns),
+            update + ((long) x * columns), columns, weight);
+    }
+}
+
+// Solves the grid with the DST method of relax_direct.c. Rank r owns interior
+// rows rowStarts[r] to rowStarts[r + 1] - 1, and after the transpose interior
+// columns columnStarts[r] to columnStarts[r + 1] - 1. A rank may own none.
+static int solveDirectDistributed(RelaxSolver* solver, int world_rank,
+    int world_size, MPI_Comm comm)
+{
+    const GridExtents* extents = &solver->extents;
+    if (extents->planes > 1)
+    {
+        return RELAX_ERROR;
+    }
+
+    int cpu = pinRank(solver, world_rank, comm);
+
+    int columns = extents->columns;
+    int interiorRows = extents->rows - 2;
+    int interiorColumns = columns - 2;
+    int rowStarts[world_size + 1];
+    int columnStarts[world_size + 1];
+    for (int i = 0; i <= world_size; i++)
+    {
+        rowStarts[i] = (int) ((long) i * interiorRows / world_size);
+        columnStarts[i] = (int) ((long) i * interiorColumns / world_size);
+    }
+    int firstRow = rowStarts[world_rank];
+    int myRows = rowStarts[world_rank + 1] - firstRow;
+    int myColumns = columnStarts[world_rank + 1] - columnStarts[world_rank];
+
+    // The slab holds this rank's rows of the grid with a halo row either side,
+    // which are only ever boundaries or zero, so need no exchange.
+    unsigned long slabElems = (unsigned long) (myRows + 2) *
+        (unsigned long) columns;
+    unsigned long rowElems = (unsigned long) myRows *
+        (unsigned long) interiorColumns;
+    unsigned long columnElems = (unsigned long) myColumns *
+        (unsigned long) interiorRows;
+    unsigned long exchangeElems = rowElems > columnElems ? rowElems :
+        columnElems;
+    size_t scratchBytes = directScratchSize(interiorRows, interiorColumns);
+    size_t arenaBytes = arenaSizeFor(sizeof(double) * slabElems) +
+        arenaSizeFor(sizeof(double) * rowElems) +
+        arenaSizeFor(sizeof(double) * columnElems) +
+        (arenaSizeFor(sizeof(double) * exchangeElems) * 2) +
+        (arenaSizeFor(sizeof(int) * (unsigned long) world_size) * 2) +
+        arenaSizeFor(sizeof(int) * 4 * (unsigned long) world_size) +
+        dstPlanArenaSize(interiorColumns) + dstPlanArenaSize(interiorRows) +
+        arenaSizeFor(scratchBytes) + arenaSizeFor(sizeof(WorkerPlacement));
+    if (world_rank == 0)
+    {
+        arenaBytes += doubleMatrixArenaSize(extents);
+    }
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        printf("Error creating arena.\n");
+        MPI_Abort(comm, -1);
+    }
+
+    double* slab = (double*) solverAlloc(solver, sizeof(double) * slabElems);
+    double* work = (double*) solverAlloc(solver, sizeof(double) * rowElems);
+    double* transposed = (double*) solverAlloc(solver, sizeof(double) *
+        columnElems);
+    double* sendBuffer = (double*) solverAlloc(solver, sizeof(double) *
+        exchangeElems);
+    double* recvBuffer = (double*) solverAlloc(solver, sizeof(double) *
+        exchangeElems);
+    int* recvCounts = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    int* recvDisplacements = (int*) solverAlloc(solver, sizeof(int) *
+        (unsigned long) world_size);
+    int* exchangeCounts = (int*) solverAlloc(solver, sizeof(int) * 4 *
+        (unsigned long) world_size);
+    double complex* scratch = (double complex*) solverAlloc(solver,
+        scratchBytes);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement));
+    DstPlan rowPlan, columnPlan;
+    if (slab == NULL || work == NULL || transposed == NULL ||
+        sendBuffer == NULL || recvBuffer == NULL || recvCounts == NULL ||
+        recvDisplacements == NULL || exchangeCounts == NULL ||
+        scratch == NULL ||
+        solver->placements == NULL ||
+        createDstPlan(&rowPlan, solver->arena, interiorColumns) != 0 ||
+        createDstPlan(&columnPlan, solver->arena, interiorRows) != 0)
+    {
+        MPI_Abort(comm, -1);
+    }
+    if (world_rank == 0)
+    {
+        solver->grid = createDoubleMatrix(solver->arena, extents);
+        if (solver->grid == NULL)
+        {
+            MPI_Abort(comm, -1);
+        }
+        initDoubleMatrixRows(solver->grid, extents, 0, extents->rows,
+            &solver->boundaries);
+    }
+    solver->placementCount = 1;
+    solver->placements[0].cpu = cpu;
+    solver->placements[0].firstRow = firstRow + 1;
+    solver->placements[0].lastRow = firstRow + myRows;
+
+    // The right-hand side, as in relax_direct.c, then along the rows.
+    initDoubleMatrixRows(slab, extents, firstRow, firstRow + myRows + 2,
+        &solver->boundaries);
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, 0);
+    for (int i = 0; i < myRows; i++)
+    {
+        const double* row = slab + ((long) (i + 1) * columns) + 1;
+        relaxRow(work + ((long) i * interiorColumns), row - columns, row,
+            row + columns, 0, interiorColumns, &solver->weights);
+    }
+    dstRows(&rowPlan, work, 0, myRows, scratch);
+
+    // Along the columns.
+    transposeDistributed(work, transposed, myRows, myColumns, columnStarts,
+        rowStarts, world_size, sendBuffer, recvBuffer, exchangeCounts, comm);
+    dstRows(&columnPlan, transposed, 0, myColumns, scratch);
+    for (int k = 0; k < myColumns; k++)
+    {
+        int column = columnStarts[world_rank] + k;
+        double horizontal = 2.0 * cos(M_PI * (column + 1) /
+            (interiorColumns + 1));
+        double* modes = transposed + ((long) k * interiorRows);
+        for (int l = 0; l < interiorRows; l++)
+        {
+            double vertical = 2.0 * cos(M_PI * (l + 1) / (interiorRows + 1));
+            modes[l] /= directDenominator(solver, vertical, horizontal);
+        }
+    }
+    dstRows(&columnPlan, transposed, 0, myColumns, scratch);
+
+    // Back along the rows, into the slab.
+    transposeDistributed(transposed, work, myColumns, myRows, rowStarts,
+        columnStarts, world_size, sendBuffer, recvBuffer, exchangeCounts,
+        comm);
+    dstRows(&rowPlan, work, 0, myRows, scratch);
+    double scale = 4.0 / ((double) (interiorRows + 1) *
+        (double) (interiorColumns + 1));
+    for (int i = 0; i < myRows; i++)
+    {
+        const double* in = work + ((long) i * interiorColumns);
+        double* out = slab + ((long) (i + 1) * columns) + 1;
+        for (int j = 0; j < interiorColumns; j++)
+        {
+            out[j] = in[j] * scale;
+        }
+    }
+
+    for (int i = 0; i < world_size; i++)
+    {
+        recvCounts[i] = (rowStarts[i + 1] - rowStarts[i]) * columns;
+        recvDisplacements[i] = (rowStarts[i] + 1) * columns;
+    }
+    int ok = MPI_Gatherv(slab + columns, myRows * columns, MPI_DOUBLE,
+        solver->grid, recvCounts, recvDisplacements, MPI_DOUBLE, 0, comm);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error gathering solution.\n");
+        MPI_Abort(comm, ok);
+    }
+
+    return RELAX_OK;
+}
+
+// Distributed transpose. Every rank holds inRows rows of a matrix, each a full
+// row of the whole matrix; rank r's rows start at inStarts[r] of the whole. The
+// result is outRows rows of the transpose per rank, split by outStarts. Each
+// rank sends every other rank the block where its rows cross their columns,
+// already transposed, in one all-to-all. counts has room for 4 * world_size
+// counts and displacements.
+static void transposeDistributed(const double* in, double* out, int inRows,
+    int outRows, const int* outStarts, const int* inStarts, int world_size,
+    double* sendBuffer, double* recvBuffer, int* counts, MPI_Comm comm)
+{
+    int inLength = outStarts[world_size];
+    int outLength = inStarts[world_size];
+    int* sendCounts = counts;
+    int* sendDisplacements = counts + world_size;
+    int* recvCounts = counts + (2 * world_size);
+    int* recvDisplacements = counts + (3 * world_size);
+
+    int offset = 0;
+    for (int d = 0; d < world_size; d++)
+    {
+        sendDisplacements[d] = offset;
+        for (int j = outStarts[d]; j < outStarts[d + 1]; j++)
+        {
+            for (int i = 0; i < inRows; i++)
+            {
+                sendBuffer[offset++] = in[((long) i * inLength) + j];
+            }
+        }
+        sendCounts[d] = offset - sendDisplacements[d];
+    }
+
+    offset = 0;
+    for (int s = 0; s < world_size; s++)
+    {
+        recvDisplacements[s] = offset;
+        recvCounts[s] = outRows * (inStarts[s + 1] - inStarts[s]);
+        offset += recvCounts[s];
+    }
+
+    int ok = MPI_Alltoallv(sendBuffer, sendCounts, sendDisplacements,
+        MPI_DOUBLE, recvBuffer, recvCounts, recvDisplacements, MPI_DOUBLE,
+        comm);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error transposing between processors.\n");
+        MPI_Abort(comm, ok);
+    }
+
+    // From rank s, row j of this rank's block comes with rank s's rows in
+    // order.
+    for (int s = 0; s < world_size; s++)
+    {
+        int rows = inStarts[s + 1] - inStarts[s];
+        const double* block = recvBuffer + recvDisplacements[s];
+        for (int j = 0; j < outRows; j++)
+        {
+            double* target = out + ((long) j * outLength) + inStarts[s];
+            for (int i = 0; i < rows; i++)
+            {
+                target[i] = block[((long) j * rows) + i];
+            }
+        }
+    }
+}
+
+// Pins the calling rank to the CPU its affinity gives it, if any, and returns
+// the CPU or -1. The rank's position on its node picks the CPU, so each node
+// hands out its own CPUs from the start.
+static int pinRank(RelaxSolver* solver, int world_rank, MPI_Comm comm)
+{
+    if (solver->affinity.policy == AFFINITY_NONE)
+    {
+        return -1;
+    }
+
+    MPI_Comm nodeComm;
+    int ok = MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, world_rank,
+        MPI_INFO_NULL, &nodeComm);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("Error splitting node communicator.\n");
+        MPI_Abort(comm, ok);
+    }
+    int node_rank;
+    MPI_Comm_rank(nodeComm, &node_rank);
+    MPI_Comm_free(&nodeComm);
+
+    int cpu = affinityCpuFor(&solver->affinity, node_rank);
+    if (pinCurrentProcess(cpu) != 0)
+    {
+        MPI_Abort(comm, -1);
+    }
+    return cpu;
+}
+
+// Relaxes the interior rows of one plane of a volume from the copy of the last
+// sweep, which holds the planes either side too. Returns the largest change.
+static double relaxPlane(double* plane, const double* copy,
+    const GridExtents* extents, JacobiRow3DKernel relaxRow,
+    const StencilWeights* weights)
+{
+    int columns = extents->columns;
+    long planeSize = (long) extents->rows * columns;
+    double maxChange = 0.0;
+
+    for (int x = 1; x < extents->rows - 1; x++)
+    {
+        const double* row = copy + ((long) x * columns);
+        double change = relaxRow(plane + ((long) x * columns), row - planeSize,
+            row - columns, row, row + columns, row + planeSize, 1, columns - 1,
+            weights);
+        maxChange = fmax(maxChange, change);
+    }
+    return maxChange;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file relax_mpi.h
+ * @brief Public API of the distributed memory (MPI) solver in librelax. Only
+ * available when the library is built with mpicc.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <mpi.h>
+
+#include "relax.h"
+
+
+// Collective over comm: every rank passes a solver configured the same way.
+// The result is gathered on rank 0 of comm; relaxGetResult returns NULL on the
+// other ranks. The worker count of the solver is ignored, as each rank is one
+// worker. RELAX_METHOD_DIRECT solves the grid exactly with distributed sine
+// transforms, RELAX_METHOD_CHEBYSHEV accelerates the Jacobi sweeps of the
+// slabs, and every other method relaxes slabs with plain Jacobi sweeps. Returns
+// RELAX_ERROR if the slabs have fewer interior rows (planes, for volumes) than
+// ranks, or the method or stencil does not support volumes. With fields set
+// (see relaxSetFields), the slabs relax every field with plain Jacobi sweeps
+// over an even split, and relaxGetFieldResult returns NULL on the other ranks;
+// RELAX_METHOD_DIRECT, RELAX_METHOD_CHEBYSHEV and rebalancing return
+// RELAX_ERROR.
+int relaxSolveDistributed(RelaxSolver* solver, MPI_Comm comm);
+
+// Every interval sweeps, times how long each rank took to relax its slab and
+// moves rows (planes, for volumes) between neighbouring ranks to even that
+// out. 0 (the default) keeps the even split of the rows for the whole solve.
+int relaxSetRebalance(RelaxSolver* solver, int interval);
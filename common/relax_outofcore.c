@@ -0,0 +1,350 @@
+/**
+ * @file relax_outofcore.c
+ * @brief Source file for the out-of-core method: in-place relaxation of a grid
+ * kept in a memory-mapped file, for grids larger than memory.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * The grid is stored in the file as raw doubles, row-major, plane after plane,
+ * exactly as relaxGetResult returns it. The file is mapped shared, so the page
+ * cache holds whatever part of it is in use and the kernel writes it back.
+ *
+ * Each pass over the file streams through the rows once but applies several
+ * sweeps. Sweep j of the pass relaxes the row j - 1 rows (planes, for volumes)
+ * behind sweep 1, so every row it reads is already at the right sweep, and the
+ * result is exactly that of running the sweeps one after another in place.
+ * Only those few rows are live at once, so the disk is read once per pass
+ * rather than once per sweep.
+ *
+ * The file is handled in bands of rows. The band ahead of the leading sweep is
+ * read ahead (MADV_WILLNEED). Once the last sweep has left a band, its write
+ * back is started (sync_file_range, since msync with MS_ASYNC does nothing on
+ * Linux) and the band is dropped from the mapping (MADV_DONTNEED), so its
+ * pages are clean and can be reclaimed before they crowd out the bands still
+ * to come, instead of waiting for dirty throttling.
+ *
+ * Convergence is checked per sweep, but a pass always completes, so the result
+ * is that of up to sweepsPerPass - 1 sweeps after the first balanced one.
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+// Target size of a band. Large enough for the disk to stream, small enough
+// that a couple of bands stay well inside memory.
+#define OUT_OF_CORE_BAND_BYTES (64UL * 1024UL * 1024UL)
+
+
+typedef struct
+{
+    char* base;
+    // The file, kept open to start the write back of each band.
+    int fd;
+    size_t rowBytes;
+    size_t pageSize;
+    // Rows (of the stack, see GridExtents) per band.
+    int bandRows;
+    int stackRows;
+} GridStore;
+
+
+// Function declarations
+static int openGridStore(RelaxSolver* solver, GridStore* store);
+static void readBandAhead(const GridStore* store, int band);
+static void releaseBand(const GridStore* store, int band);
+static void bandRange(const GridStore* store, int band, bool inner,
+    size_t* offset, size_t* length);
+
+
+// Function definitions
+int solveOutOfCore(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    bool volume = (extents->planes > 1);
+    if (solver->storePath == NULL ||
+        (volume && selectInplaceRow3D(solver->stencil) == NULL))
+    {
+        return RELAX_ERROR;
+    }
+
+    if (prepareSolve(solver, arenaSizeFor(sizeof(WorkerPlacement))) !=
+        RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement));
+    if (solver->placements == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    GridStore store;
+    if (openGridStore(solver, &store) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+    solver->grid = (double*) store.base;
+
+    int cpu = affinityCpuFor(&solver->affinity, 0);
+    if (cpu >= 0 && pinCurrentThread(cpu) != 0)
+    {
+        cpu = -1;
+    }
+    solver->placementCount = 1;
+    solver->placements[0].cpu = cpu;
+    solver->placements[0].firstRow = 0;
+    solver->placements[0].lastRow = store.stackRows - 1;
+
+    int rows = extents->rows;
+    int columns = extents->columns;
+    int stackRows = store.stackRows;
+    long planeSize = (long) rows * columns;
+    // Each sweep trails the one before by the rows a row reads ahead of
+    // itself: the next row, or for volumes the same row of the next plane.
+    int lag = volume ? rows : 1;
+    int sweeps = solver->sweepsPerPass;
+    int bands = (stackRows + store.bandRows - 1) / store.bandRows;
+    InplaceRowKernel relaxRow = selectInplaceRow(solver->stencil);
+    InplaceRow3DKernel relaxVolumeRow = selectInplaceRow3D(solver->stencil);
+
+    double maxChanges[sweeps];
+    bool stop = false;
+    while (!stop)
+    {
+        for (int j = 0; j < sweeps; j++)
+        {
+            maxChanges[j] = 0.0;
+        }
+        readBandAhead(&store, 0);
+        readBandAhead(&store, 1);
+        int released = 0;
+
+        // Step t relaxes row t with the first sweep, row t - lag with the
+        // second, and so on. Sweeps run first to last within a step, so a
+        // later sweep always reads rows the earlier one has just finished.
+        int steps = (stackRows - 2) + ((sweeps - 1) * lag);
+        for (int t = 1; t <= steps; t++)
+        {
+            // Row t + lag is the furthest ahead this step reads.
+            if ((t + lag) % store.bandRows == 0)
+            {
+                readBandAhead(&store, ((t + lag) / store.bandRows) + 1);
+            }
+
+            for (int j = 0; j < sweeps; j++)
+            {
+                int r = t - (j * lag);
+                if (r < 1 || r > stackRows - 2)
+                {
+                    continue;
+                }
+                int x = r % rows;
+                int z = r / rows;
+                if (x == 0 || x == rows - 1 ||
+                    (volume && (z == 0 || z == extents->planes - 1)))
+                {
+                    continue;
+                }
+
+                double* row = solver->grid + ((long) r * columns);
+                double change;
+                if (volume)
+                {
+                    change = relaxVolumeRow(row - planeSize, row - columns,
+                        row, row + columns, row + planeSize, 1, columns - 1,
+                        &solver->weights);
+                }
+                else
+                {
+                    change = relaxRow(row - columns, row, row + columns, 1,
+                        columns - 1, &solver->weights);
+                }
+                maxChanges[j] = fmax(maxChanges[j], change);
+            }
+
+            // The last sweep has reached row t - (sweeps - 1) * lag, and reads
+            // at most lag rows behind it, so bands wholly before that are
+            // finished for this pass.
+            int finished = t - (sweeps * lag);
+            while (released < bands &&
+                (released + 1) * store.bandRows <= finished)
+            {
+                releaseBand(&store, released++);
+            }
+        }
+        while (released < bands)
+        {
+            releaseBand(&store, released++);
+        }
+
+        for (int j = 0; j < sweeps; j++)
+        {
+            solver->iterations++;
+            if (reportProgress(solver, solver->iterations, maxChanges[j],
+                0.0) != 0 || maxChanges[j] <= solver->precision)
+            {
+                stop = true;
+            }
+        }
+    }
+
+    // Wait for the write back, so the file holds the result when the solve
+    // returns.
+    if (msync(store.base, store.rowBytes * (size_t) stackRows, MS_SYNC) != 0)
+    {
+        perror("msync() error");
+        return RELAX_ERROR;
+    }
+
+    return atomic_load(&solver->cancelled) ? RELAX_CANCELLED : RELAX_OK;
+}
+
+// Unmaps and closes the file of the last out-of-core solve, if any. The file
+// itself is kept.
+void closeGridStore(RelaxSolver* solver)
+{
+    if (solver->storeMapping == NULL)
+    {
+        return;
+    }
+    munmap(solver->storeMapping, solver->storeLength);
+    close(solver->storeFd);
+    solver->storeFd = -1;
+    solver->storeMapping = NULL;
+    solver->storeLength = 0;
+    solver->grid = NULL;
+}
+
+// Creates (or truncates) the file, maps it and writes the initial grid band by
+// band, so initialising does not need the grid in memory either.
+static int openGridStore(RelaxSolver* solver, GridStore* store)
+{
+    const GridExtents* extents = &solver->extents;
+    store->rowBytes = sizeof(double) * (size_t) extents->columns;
+    store->stackRows = extents->rows * extents->planes;
+    store->pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t length = store->rowBytes * (size_t) store->stackRows;
+
+    // A band must hold every row the sweeps of a pass have in flight.
+    int lag = (extents->planes > 1) ? extents->rows : 1;
+    store->bandRows = (int) (OUT_OF_CORE_BAND_BYTES / store->rowBytes);
+    if (store->bandRows < (solver->sweepsPerPass + 1) * lag)
+    {
+        store->bandRows = (solver->sweepsPerPass + 1) * lag;
+    }
+
+    int fd = open(solver->storePath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        perror("open() error");
+        return RELAX_ERROR;
+    }
+    if (ftruncate(fd, (off_t) length) != 0)
+    {
+        perror("ftruncate() error");
+        close(fd);
+        return RELAX_ERROR;
+    }
+    void* mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+        0);
+    if (mapping == MAP_FAILED)
+    {
+        perror("mmap() error");
+        close(fd);
+        return RELAX_ERROR;
+    }
+    store->base = (char*) mapping;
+    store->fd = fd;
+    solver->storeMapping = mapping;
+    solver->storeFd = fd;
+    solver->storeLength = length;
+
+    // Passes run front to back; tell the kernel not to keep pages around
+    // behind the current position.
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    int bands = (store->stackRows + store->bandRows - 1) / store->bandRows;
+    for (int band = 0; band < bands; band++)
+    {
+        int firstRow = band * store->bandRows;
+        int lastRow = firstRow + store->bandRows;
+        if (lastRow > store->stackRows)
+        {
+            lastRow = store->stackRows;
+        }
+        initSolverRows(solver, (double*) (store->base + (store->rowBytes *
+            (size_t) firstRow)), firstRow, lastRow);
+        releaseBand(store, band);
+    }
+    return RELAX_OK;
+}
+
+// Asks the kernel to start reading the band in.
+static void readBandAhead(const GridStore* store, int band)
+{
+    size_t offset, length;
+    bandRange(store, band, false, &offset, &length);
+    if (length > 0)
+    {
+        madvise(store->base + offset, length, MADV_WILLNEED);
+    }
+}
+
+// Starts writing the band back without waiting for it, and drops it from the
+// mapping. Pages still being written stay in the page cache, so nothing is
+// lost; they are just no longer counted against this process.
+static void releaseBand(const GridStore* store, int band)
+{
+    size_t offset, length;
+    bandRange(store, band, true, &offset, &length);
+    if (length > 0)
+    {
+        sync_file_range(store->fd, (off_t) offset, (off_t) length,
+            SYNC_FILE_RANGE_WRITE);
+        madvise(store->base + offset, length, MADV_DONTNEED);
+    }
+}
+
+// Page-aligned byte range of a band. The inner range leaves out pages shared
+// with the neighbouring bands, which may still be in use.
+static void bandRange(const GridStore* store, int band, bool inner,
+    size_t* offset, size_t* length)
+{
+    size_t total = store->rowBytes * (size_t) store->stackRows;
+    size_t first = store->rowBytes * (size_t) band * (size_t) store->bandRows;
+    size_t last = first + (store->rowBytes * (size_t) store->bandRows);
+    if (last > total)
+    {
+        last = total;
+    }
+
+    size_t page = store->pageSize;
+    if (inner)
+    {
+        first = (first + page - 1) / page * page;
+        if (last < total)
+        {
+            last = last / page * page;
+        }
+    }
+    else
+    {
+        first = first / page * page;
+    }
+
+    *offset = first;
+    *length = (first < last) ? last - first : 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file relax_pool.c
+ * @brief Source file for the persistent worker pool used to solve batches of
+ * small, independent grids.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * For grids of tens to a few hundred cells per side, starting a process or
+ * creating threads costs more than the solve itself. The pool creates its
+ * threads once. Each batch is handed out one grid at a time from a shared
+ * counter, so a thread that finishes a small grid early simply takes the
+ * next one.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "relax_internal.h"
+
+
+struct RelaxPool
+{
+    int workers;
+    pthread_t* threads;
+
+    pthread_mutex_t lock;
+    // Signalled when a new batch is posted, or the pool is shutting down.
+    pthread_cond_t start;
+    // Signalled when the last worker finishes the current batch.
+    pthread_cond_t finished;
+
+    // The current batch. Guarded by lock, apart from next and failures.
+    RelaxSolver** batch;
+    int count;
+    unsigned long generation;
+    int busy;
+    bool shutdown;
+    atomic_int next;
+    atomic_int failures;
+};
+
+
+static void* poolWorker(void* arg)
+{
+    RelaxPool* pool = (RelaxPool*) arg;
+    unsigned long seen = 0;
+
+    while (true)
+    {
+        if (pthread_mutex_lock(&pool->lock) != 0)
+        {
+            perror("pthread_mutex_lock() error");
+            exit(-1);
+        }
+        while (pool->generation == seen && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        RelaxSolver** batch = pool->batch;
+        int count = pool->count;
+        pthread_mutex_unlock(&pool->lock);
+
+        while (true)
+        {
+            int i = atomic_fetch_add(&pool->next, 1);
+            if (i >= count)
+            {
+                break;
+            }
+            if (relaxSolve(batch[i]) != RELAX_OK)
+            {
+                atomic_fetch_add(&pool->failures, 1);
+            }
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->busy--;
+        if (pool->busy == 0)
+        {
+            pthread_cond_signal(&pool->finished);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+RelaxPool* relaxCreatePool(int workers)
+{
+    if (workers < 1)
+    {
+        return NULL;
+    }
+
+    RelaxPool* pool = (RelaxPool*) calloc(1, sizeof(RelaxPool));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+    pool->threads = (pthread_t*) malloc(sizeof(pthread_t) *
+        (unsigned long) workers);
+    if (pool->threads == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->finished, NULL);
+    atomic_init(&pool->next, 0);
+    atomic_init(&pool->failures, 0);
+
+    for (int i = 0; i < workers; i++)
+    {
+        if (pthread_create(&pool->threads[i], NULL, poolWorker, pool) != 0)
+        {
+            perror("pthread_create() error");
+            // Shut down the threads that did start.
+            pool->workers = i;
+            relaxDestroyPool(pool);
+            return NULL;
+        }
+    }
+    pool->workers = workers;
+
+    return pool;
+}
+
+int relaxSolveBatch(RelaxPool* pool, RelaxSolver** solvers, int count)
+{
+    if (count <= 0)
+    {
+        return RELAX_OK;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->batch = solvers;
+    pool->count = count;
+    pool->busy = pool->workers;
+    atomic_store(&pool->next, 0);
+    atomic_store(&pool->failures, 0);
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+
+    while (pool->busy > 0)
+    {
+        pthread_cond_wait(&pool->finished, &pool->lock);
+    }
+    pool->batch = NULL;
+    pthread_mutex_unlock(&pool->lock);
+
+    return atomic_load(&pool->failures) == 0 ? RELAX_OK : RELAX_ERROR;
+}
+
+void relaxDestroyPool(RelaxPool* pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->workers; i++)
+    {
+        if (pthread_join(pool->threads[i], NULL) != 0)
+        {
+            perror("pthread_join() error");
+        }
+    }
+
+    pthread_cond_destroy(&pool->finished);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool);
+}
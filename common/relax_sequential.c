@@ -0,0 +1,188 @@
+/**
+ * @file relax_sequential.c
+ * @brief Source file for the sequential Jacobi method, used as the reference
+ * answer when testing the parallel methods.
+ * @date 03/01/2022
+ * @author dancs-dev
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+#include "tiles.h"
+
+
+static double sweepTiles(TileMap* tiles, double* matrix, const double* copy,
+    const GridExtents* extents, JacobiRowKernel relaxRow,
+    const StencilWeights* weights);
+static double sweepVolume(double* matrix, const double* copy,
+    const GridExtents* extents, JacobiRow3DKernel relaxRow,
+    const StencilWeights* weights);
+
+
+int solveJacobi(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    int rows = extents->rows;
+    int columns = extents->columns;
+    double precision = solver->precision;
+
+    // Volumes are not tiled.
+    bool volume = (extents->planes > 1);
+    int tileSize = volume ? 0 : solver->tileSize;
+    JacobiRow3DKernel relaxVolumeRow = NULL;
+    if (volume)
+    {
+        relaxVolumeRow = selectJacobiRow3D(solver->stencil);
+        if (relaxVolumeRow == NULL)
+        {
+            return RELAX_ERROR;
+        }
+    }
+
+    if (prepareSolve(solver, (doubleMatrixArenaSize(extents) * 2) +
+        tileMapArenaSize(rows, columns, tileSize)) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    solver->grid = createDoubleMatrix(solver->arena, extents);
+    double* doubleMatrix = solver->grid;
+    double* doubleMatrixCopy = createDoubleMatrix(solver->arena, extents);
+    if (doubleMatrix == NULL || doubleMatrixCopy == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    initSolverRows(solver, doubleMatrix, 0, rows * extents->planes);
+
+    // Without tiling this is a single tile that is always active.
+    TileMap tiles;
+    if (createTileMap(&tiles, solver->arena, rows, columns, tileSize,
+        solver->wakeFraction * precision) != 0)
+    {
+        return RELAX_ERROR;
+    }
+
+    // Small square grids of a specialised size are swept by a fully unrolled
+    // kernel, as long as there are no tiles to skip.
+    JacobiRowKernel relaxRow = selectJacobiRow(solver->stencil, tiles.tileSize);
+    FixedJacobiKernel relaxGrid = NULL;
+    if (!volume && tileSize == 0 && rows == columns)
+    {
+        relaxGrid = selectFixedJacobi(solver->stencil, rows);
+    }
+
+    size_t gridBytes = sizeof(double) * gridCells(extents);
+
+    while (true)
+    {
+        memcpy(doubleMatrixCopy, doubleMatrix, gridBytes);
+
+        int skipped = selectActiveTiles(&tiles);
+        double maxChange;
+        if (volume)
+        {
+            maxChange = sweepVolume(doubleMatrix, doubleMatrixCopy, extents,
+                relaxVolumeRow, &solver->weights);
+            tiles.change[0] = maxChange;
+        }
+        else if (relaxGrid != NULL)
+        {
+            maxChange = relaxGrid(doubleMatrix, doubleMatrixCopy,
+                &solver->weights);
+            tiles.change[0] = maxChange;
+        }
+        else
+        {
+            maxChange = sweepTiles(&tiles, doubleMatrix, doubleMatrixCopy,
+                extents, relaxRow, &solver->weights);
+        }
+        solver->iterations++;
+
+        if (reportProgress(solver, solver->iterations, maxChange, 0.0) != 0)
+        {
+            return RELAX_CANCELLED;
+        }
+        if (maxChange <= precision)
+        {
+            // A balanced sweep only counts if no tile was skipped. Otherwise
+            // confirm it with a full sweep.
+            if (skipped == 0)
+            {
+                break;
+            }
+            wakeAllTiles(&tiles);
+        }
+    }
+    return RELAX_OK;
+}
+
+// Relaxes the active tiles of the grid from the copy of the last sweep, and
+// records the largest change of each. Returns the largest change overall.
+static double sweepTiles(TileMap* tiles, double* matrix, const double* copy,
+    const GridExtents* extents, JacobiRowKernel relaxRow,
+    const StencilWeights* weights)
+{
+    int rows = extents->rows;
+    int columns = extents->columns;
+    int tileSize = tiles->tileSize;
+    int tilesAcross = tiles->tilesAcross;
+    double maxChange = 0.0;
+
+    for (int x = 1; x < rows - 1; x++)
+    {
+        const double* up = copy + ((long) (x - 1) * columns);
+        const double* row = copy + ((long) x * columns);
+        const double* down = copy + ((long) (x + 1) * columns);
+        double* target = matrix + ((long) x * columns);
+        // The first tile of the row; the rest follow it.
+        int tileRow = tileIndex(tiles, x, 1);
+        for (int t = 0; t < tilesAcross; t++)
+        {
+            if (!tiles->active[tileRow + t])
+            {
+                continue;
+            }
+            int yEnd = 1 + ((t + 1) * tileSize);
+            if (yEnd > columns - 1)
+            {
+                yEnd = columns - 1;
+            }
+
+            double change = relaxRow(target, up, row, down, 1 + (t * tileSize),
+                yEnd, weights);
+            tiles->change[tileRow + t] = fmax(tiles->change[tileRow + t],
+                change);
+            maxChange = fmax(maxChange, change);
+        }
+    }
+    return maxChange;
+}
+
+// Relaxes the interior of a volume from the copy of the last sweep. Returns
+// the largest change.
+static double sweepVolume(double* matrix, const double* copy,
+    const GridExtents* extents, JacobiRow3DKernel relaxRow,
+    const StencilWeights* weights)
+{
+    int columns = extents->columns;
+    long planeSize = (long) extents->rows * columns;
+    double maxChange = 0.0;
+
+    for (int z = 1; z < extents->planes - 1; z++)
+    {
+        for (int x = 1; x < extents->rows - 1; x++)
+        {
+            long offset = ((long) z * planeSize) + ((long) x * columns);
+            const double* row = copy + offset;
+            double change = relaxRow(matrix + offset, row - planeSize,
+                row - columns, row, row + columns, row + planeSize, 1,
+                columns - 1, weights);
+            maxChange = fmax(maxChange, change);
+        }
+    }
+    return maxChange;
+}
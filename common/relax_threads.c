@@ -0,0 +1,471 @@
+/**
+ * @file relax_threads.c
+ * @brief Source file for the shared memory method: in-place relaxation by a
+ * team of pthreads, with a mutex protecting each row.
+ * @date 28/10/2021
+ * @author dancs-dev
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+#include "tiles.h"
+
+
+// To enable protected reads, uncomment the below line:
+// It will lock more than one column at a time. I believe this is safe, but it
+// has not been thoroughly tested. Intended usage: this should be disabled.
+// #define PROTECTED_READS
+
+
+// Sweeps a worker has finished, for the telemetry skew. Each counter has a
+// cache line to itself, so publishing it does not invalidate the others.
+typedef struct
+{
+    _Alignas(64) atomic_int sweeps;
+} SweepCounter;
+
+typedef struct
+{
+    RelaxSolver* solver;
+    pthread_mutex_t* mutexArray;
+    SweepCounter* sweepCounters;
+    // One tile map per worker. Every worker sweeps the whole grid, so each
+    // tracks for itself which tiles it still needs to visit.
+    TileMap* tiles;
+    pthread_barrier_t initBarrier;
+} ThreadsContext;
+
+typedef struct
+{
+    ThreadsContext* context;
+    int tid;
+} WorkerArgs;
+
+
+// Function declarations
+static void* relaxationWorker(void* arg);
+static double sweepTiles(ThreadsContext* context, TileMap* tiles,
+    InplaceRowKernel relaxRow, bool locking);
+static double sweepVolume(ThreadsContext* context, InplaceRow3DKernel relaxRow,
+    bool locking);
+static void lockMutexes(pthread_mutex_t* array, int row);
+static void unlockMutexes(pthread_mutex_t* array, int row);
+static double sweepSkew(const SweepCounter* counters, int workers);
+
+
+// Function definitions
+int solveThreads(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    int workers = solver->workers;
+    // Rows of every plane, each with its own mutex.
+    int stackRows = extents->rows * extents->planes;
+
+    // Volumes are not tiled.
+    int tileSize = extents->planes > 1 ? 0 : solver->tileSize;
+    if (extents->planes > 1 && selectInplaceRow3D(solver->stencil) == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    // Every buffer of the solve comes from one huge page backed arena.
+    size_t arenaBytes = doubleMatrixArenaSize(extents) +
+        arenaSizeFor(sizeof(pthread_mutex_t) * (unsigned long) stackRows) +
+        arenaSizeFor(sizeof(WorkerPlacement) * (unsigned long) workers) +
+        arenaSizeFor(sizeof(TileMap) * (unsigned long) workers) +
+        arenaSizeFor(sizeof(SweepCounter) * (unsigned long) workers) +
+        (tileMapArenaSize(extents->rows, extents->columns, tileSize) *
+        (unsigned long) workers);
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    // The grid is allocated here, but each worker initialises its own band of
+    // rows before relaxing (see relaxationWorker).
+    ThreadsContext context;
+    context.solver = solver;
+    solver->grid = createDoubleMatrix(solver->arena, extents);
+    context.mutexArray = (pthread_mutex_t*) solverAlloc(solver,
+        sizeof(pthread_mutex_t) * (unsigned long) stackRows);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement) * (unsigned long) workers);
+    context.tiles = (TileMap*) solverAlloc(solver, sizeof(TileMap) *
+        (unsigned long) workers);
+    context.sweepCounters = (SweepCounter*) solverAlloc(solver,
+        sizeof(SweepCounter) * (unsigned long) workers);
+    if (solver->grid == NULL || context.mutexArray == NULL ||
+        solver->placements == NULL || context.tiles == NULL ||
+        context.sweepCounters == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    for (int i = 0; i < workers; i++)
+    {
+        atomic_init(&context.sweepCounters[i].sweeps, 0);
+        if (createTileMap(&context.tiles[i], solver->arena, extents->rows,
+            extents->columns, tileSize,
+            solver->wakeFraction * solver->precision) != 0)
+        {
+            return RELAX_ERROR;
+        }
+    }
+    solver->placementCount = workers;
+
+    for (int i = 0; i < stackRows; i++)
+    {
+        if (pthread_mutex_init(&context.mutexArray[i], NULL) != 0)
+        {
+            perror("pthread_mutex_init() error");
+            return RELAX_ERROR;
+        }
+    }
+
+    if (pthread_barrier_init(&context.initBarrier, NULL,
+        (unsigned int) workers) != 0)
+    {
+        perror("pthread_barrier_init() error");
+        return RELAX_ERROR;
+    }
+
+    // Create a pthread type pointer array.
+    pthread_t threads[workers];
+    // Each thread gets its own arguments. Passing the address of the loop
+    // counter would let the id change before the thread has read it.
+    WorkerArgs args[workers];
+
+    int status = RELAX_OK;
+    for (int i = 0; i < workers; i++)
+    {
+        args[i].context = &context;
+        args[i].tid = i;
+        // A single worker runs on the calling thread (and pins it, if an
+        // affinity is set). This keeps small solves, and solves on pool
+        // threads, free of thread creation.
+        if (workers == 1)
+        {
+            relaxationWorker(&args[i]);
+            break;
+        }
+        if (pthread_create(&threads[i], NULL, relaxationWorker, &args[i]) != 0)
+        {
+            // The barrier cannot complete without every worker, so there is no
+            // way to recover the threads already started.
+            perror("pthread_create() error");
+            exit(-1);
+        }
+    }
+
+    for (int i = 0; i < workers && workers > 1; i++)
+    {
+        if (pthread_join(threads[i], NULL) != 0)
+        {
+            perror("pthread_join() error");
+            status = RELAX_ERROR;
+        }
+    }
+
+    for (int i = 0; i < stackRows; i++)
+    {
+        if (pthread_mutex_destroy(&context.mutexArray[i]) != 0)
+        {
+            perror("pthread_mutex_destroy() error");
+            status = RELAX_ERROR;
+        }
+    }
+    pthread_barrier_destroy(&context.initBarrier);
+
+    if (status == RELAX_OK && atomic_load(&solver->cancelled))
+    {
+        status = RELAX_CANCELLED;
+    }
+    return status;
+}
+
+// This method should guarantee a precision of at least the precision that is
+// set. It may be more precise as the threads finish. I.e., if precision is
+// reached, and there are 20 threads running, all of the threads will finish
+// their computations (through the whole array) before potentially returning. If
+// in the iteration, a calculation was done that was out of a precision, it will
+// do another precision before returning. This may seem wasteful, but the
+// overhead compared to other solutions is actually reasonably small.
+static void* relaxationWorker(void* arg)
+{
+    WorkerArgs* args = (WorkerArgs*) arg;
+    ThreadsContext* context = args->context;
+    RelaxSolver* solver = context->solver;
+    int tid = args->tid;
+
+    const GridExtents* extents = &solver->extents;
+    int columns = extents->columns;
+    int stackRows = extents->rows * extents->planes;
+    double precision = solver->precision;
+    double* matrix = solver->grid;
+
+    int cpu = affinityCpuFor(&solver->affinity, tid);
+    if (cpu >= 0 && pinCurrentThread(cpu) != 0)
+    {
+        cpu = -1;
+    }
+
+    // First touch: each thread writes the initial values of its own band of
+    // rows, so the kernel places those pages on the thread's NUMA node rather
+    // than on the node of the main thread. The bands match the even split of
+    // rows (of every plane, for volumes) across workers.
+    int firstRow = (int) ((long) tid * stackRows / solver->workers);
+    int lastRow = (int) ((long) (tid + 1) * stackRows / solver->workers);
+    initSolverRows(solver, matrix + ((long) firstRow * columns), firstRow,
+        lastRow);
+
+    solver->placements[tid].cpu = cpu;
+    solver->placements[tid].firstRow = firstRow;
+    solver->placements[tid].lastRow = lastRow - 1;
+
+    // Nobody may read a neighbouring band before its owner has written it.
+    int ok = pthread_barrier_wait(&context->initBarrier);
+    if (ok != 0 && ok != PTHREAD_BARRIER_SERIAL_THREAD)
+    {
+        perror("pthread_barrier_wait() error");
+        exit(-1);
+    }
+
+    // A lone worker has nobody to race with, so skips the row locks.
+    bool locking = (solver->workers > 1);
+
+    // Without tiling this is a single tile that is always active.
+    TileMap* tiles = &context->tiles[tid];
+    InplaceRowKernel relaxRow = selectInplaceRow(solver->stencil);
+    InplaceRow3DKernel relaxVolumeRow = selectInplaceRow3D(solver->stencil);
+    bool volume = (extents->planes > 1);
+
+    // A lone worker on a small square grid of a specialised size sweeps it
+    // with a fully unrolled kernel, as long as there are no tiles to skip.
+    FixedInplaceKernel relaxGrid = NULL;
+    if (!locking && !volume && solver->tileSize == 0 &&
+        extents->rows == columns)
+    {
+        relaxGrid = selectFixedInplace(solver->stencil, columns);
+    }
+
+    // Only worker 0 reports progress. The others only publish their sweep
+    // count, for the skew, and only while somebody is listening.
+    bool listening = (solver->progress != NULL || solver->telemetry != NULL);
+    bool reporting = (tid == 0 && listening);
+    atomic_int* sweeps = &context->sweepCounters[tid].sweeps;
+    int iterations = 0;
+
+    while (true)
+    {
+        int skipped = selectActiveTiles(tiles);
+        double maxChange;
+        if (volume)
+        {
+            maxChange = sweepVolume(context, relaxVolumeRow, locking);
+            tiles->change[0] = maxChange;
+        }
+        else if (relaxGrid != NULL)
+        {
+            maxChange = relaxGrid(matrix, &solver->weights);
+            tiles->change[0] = maxChange;
+        }
+        else
+        {
+            maxChange = sweepTiles(context, tiles, relaxRow, locking);
+        }
+        iterations++;
+
+        if (listening)
+        {
+            atomic_store_explicit(sweeps, iterations, memory_order_relaxed);
+        }
+        if (reporting)
+        {
+            reportProgress(solver, iterations, maxChange,
+                sweepSkew(context->sweepCounters, solver->workers));
+        }
+        if (atomic_load(&solver->cancelled))
+        {
+            break;
+        }
+        if (maxChange <= precision)
+        {
+            // A balanced sweep only counts if no tile was skipped. Otherwise
+            // confirm it with a full sweep.
+            if (skipped == 0)
+            {
+                break;
+            }
+            wakeAllTiles(tiles);
+        }
+    }
+
+    if (tid == 0)
+    {
+        solver->iterations = iterations;
+    }
+
+    return NULL;
+}
+
+// Relaxes the active tiles of the grid in place, row by row, and records the
+// largest change of each. Returns the largest change overall.
+static double sweepTiles(ThreadsContext* context, TileMap* tiles,
+    InplaceRowKernel relaxRow, bool locking)
+{
+    int rows = context->solver->extents.rows;
+    int columns = context->solver->extents.columns;
+    double* matrix = context->solver->grid;
+    const StencilWeights* weights = &context->solver->weights;
+    pthread_mutex_t* mutexArray = context->mutexArray;
+    int tileSize = tiles->tileSize;
+    int tilesAcross = tiles->tilesAcross;
+    double maxChange = 0.0;
+
+    for (int x = 1; x < rows - 1; x++)
+    {
+        // Initial design idea involved protecting each value in matrix with
+        // a mutex. That gave a rubbish efficiency. Let's protect each row
+        // instead: we may spend some more time blocked, but at least we can
+        // avoid the tremendous overhead from setting the lock for each
+        // element in the 2D array.
+        if (locking)
+        {
+            lockMutexes(mutexArray, x);
+        }
+        double* row = matrix + ((long) x * columns);
+        // The first tile of the row; the rest follow it.
+        int tileRow = tileIndex(tiles, x, 1);
+        for (int t = 0; t < tilesAcross; t++)
+        {
+            if (!tiles->active[tileRow + t])
+            {
+                continue;
+            }
+            int yEnd = 1 + ((t + 1) * tileSize);
+            if (yEnd > columns - 1)
+            {
+                yEnd = columns - 1;
+            }
+
+            double change = relaxRow(row - columns, row, row + columns,
+                1 + (t * tileSize), yEnd, weights);
+            tiles->change[tileRow + t] = fmax(tiles->change[tileRow + t],
+                change);
+            maxChange = fmax(maxChange, change);
+        }
+        if (locking)
+        {
+            unlockMutexes(mutexArray, x);
+        }
+    }
+    return maxChange;
+}
+
+// Relaxes the interior of a volume in place, plane by plane and row by row.
+// Each row of the stack of planes has its own mutex. Returns the largest
+// change.
+static double sweepVolume(ThreadsContext* context, InplaceRow3DKernel relaxRow,
+    bool locking)
+{
+    int rows = context->solver->extents.rows;
+    int columns = context->solver->extents.columns;
+    int planes = context->solver->extents.planes;
+    long planeSize = (long) rows * columns;
+    double* matrix = context->solver->grid;
+    const StencilWeights* weights = &context->solver->weights;
+    double maxChange = 0.0;
+
+    for (int z = 1; z < planes - 1; z++)
+    {
+        for (int x = 1; x < rows - 1; x++)
+        {
+            int stackRow = (z * rows) + x;
+            if (locking)
+            {
+                lockMutexes(context->mutexArray, stackRow);
+            }
+            double* row = matrix + ((long) stackRow * columns);
+            double change = relaxRow(row - planeSize, row - columns, row,
+                row + columns, row + planeSize, 1, columns - 1, weights);
+            maxChange = fmax(maxChange, change);
+            if (locking)
+            {
+                unlockMutexes(context->mutexArray, stackRow);
+            }
+        }
+    }
+    return maxChange;
+}
+
+static void lockMutexes(pthread_mutex_t* array, int row)
+{
+    #ifdef PROTECTED_READS
+    if (pthread_mutex_lock(&array[row - 1]) != 0)
+    {
+        perror("pthread_mutex_lock() error");
+        exit(-1);
+    }
+    #endif
+
+    if (pthread_mutex_lock(&array[row]) != 0)
+    {
+        perror("pthread_mutex_lock() error");
+        exit(-1);
+    }
+
+    #ifdef PROTECTED_READS
+    if (pthread_mutex_lock(&array[row + 1]) != 0)
+    {
+        perror("pthread_mutex_lock() error");
+        exit(-1);
+    }
+    #endif
+}
+
+static void unlockMutexes(pthread_mutex_t* array, int row)
+{
+    // If we use protected reads, ensure we release the locks in reverse order
+    // from which we used them.
+    #ifdef PROTECTED_READS
+    if (pthread_mutex_unlock(&array[row + 1]) != 0)
+    {
+        perror("pthread_mutex_unlock() error");
+        exit(-1);
+    }
+    #endif
+    if (pthread_mutex_unlock(&array[row]) != 0)
+    {
+        perror("pthread_mutex_unlock() error");
+        exit(-1);
+    }
+    #ifdef PROTECTED_READS
+    if (pthread_mutex_unlock(&array[row - 1]) != 0)
+    {
+        perror("pthread_mutex_unlock() error");
+        exit(-1);
+    }
+    #endif
+}
+
+// Sweeps between the furthest ahead and the furthest behind worker. The
+// counters are read without synchronisation, so this is a snapshot.
+static double sweepSkew(const SweepCounter* counters, int workers)
+{
+    int lowest = atomic_load_explicit(&counters[0].sweeps,
+        memory_order_relaxed);
+    int highest = lowest;
+    for (int i = 1; i < workers; i++)
+    {
+        int sweeps = atomic_load_explicit(&counters[i].sweeps,
+            memory_order_relaxed);
+        lowest = sweeps < lowest ? sweeps : lowest;
+        highest = sweeps > highest ? sweeps : highest;
+    }
+    return (double) (highest - lowest);
+}
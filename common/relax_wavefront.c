@@ -0,0 +1,310 @@
+/**
+ * @file relax_wavefront.c
+ * @brief Source file for the wavefront method: pipelined in-place relaxation,
+ * with each thread a few rows behind the one before it.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Sweep k (counting from 1) belongs to worker (k - 1) % workers, so with T
+ * workers T consecutive sweeps are in flight at once. Each sweep relaxes the
+ * grid in place, row by row, exactly as a single threaded Gauss-Seidel sweep
+ * would. Before relaxing a row, a worker waits until the previous sweep has
+ * finished every row that reads it or that it reads, so every value it sees is
+ * the one a single thread would see. Results are therefore identical to the
+ * sequential in-place method run for the same number of sweeps, run to run.
+ *
+ * Workers publish their position in a padded atomic counter each (release),
+ * which the next worker spins on (acquire). There are no mutexes.
+ *
+ * Stopping is deterministic too. A worker only starts sweep k if no sweep up
+ * to k - T was balanced (or cancelled). Those sweeps are guaranteed to have
+ * finished, so the decision never depends on timing. If sweep s is the first
+ * balanced one, sweeps s + 1 to s + T - 1 are already in flight and complete,
+ * and the result is that of sweep s + T - 1.
+ */
+
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "matrix.h"
+#include "relax_internal.h"
+
+
+// Spins before giving up the CPU while waiting for the previous sweep.
+#define WAVEFRONT_SPINS 1000
+
+
+// Position of a worker: (sweep - 1) * rows + the next row of the stack (see
+// GridExtents) it will relax, so it only ever grows. Finishing sweep k sets it
+// to k * rows. Each counter has a cache line to itself, so publishing it does
+// not invalidate the counters of the other workers.
+typedef struct
+{
+    _Alignas(64) atomic_long position;
+} ProgressCounter;
+
+typedef struct
+{
+    RelaxSolver* solver;
+    ProgressCounter* progress;
+    // First sweep that was balanced or cancelled, or INT_MAX.
+    atomic_int stopSweep;
+    atomic_int lastSweep;
+    pthread_barrier_t initBarrier;
+} WavefrontContext;
+
+typedef struct
+{
+    WavefrontContext* context;
+    int tid;
+} WavefrontArgs;
+
+
+// Function declarations
+static void* wavefrontWorker(void* arg);
+static void waitForPosition(atomic_long* position, long target);
+static void lowerTo(atomic_int* value, int bound);
+static void raiseTo(atomic_int* value, int bound);
+
+
+// Function definitions
+int solveWavefront(RelaxSolver* solver)
+{
+    const GridExtents* extents = &solver->extents;
+    int workers = solver->workers;
+
+    if (extents->planes > 1 && selectInplaceRow3D(solver->stencil) == NULL)
+    {
+        return RELAX_ERROR;
+    }
+
+    size_t arenaBytes = doubleMatrixArenaSize(extents) +
+        arenaSizeFor(sizeof(ProgressCounter) * (unsigned long) workers) +
+        arenaSizeFor(sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (prepareSolve(solver, arenaBytes) != RELAX_OK)
+    {
+        return RELAX_ERROR;
+    }
+
+    WavefrontContext context;
+    context.solver = solver;
+    solver->grid = createDoubleMatrix(solver->arena, extents);
+    context.progress = (ProgressCounter*) solverAlloc(solver,
+        sizeof(ProgressCounter) * (unsigned long) workers);
+    solver->placements = (WorkerPlacement*) solverAlloc(solver,
+        sizeof(WorkerPlacement) * (unsigned long) workers);
+    if (solver->grid == NULL || context.progress == NULL ||
+        solver->placements == NULL)
+    {
+        return RELAX_ERROR;
+    }
+    solver->placementCount = workers;
+
+    for (int i = 0; i < workers; i++)
+    {
+        atomic_init(&context.progress[i].position, 0);
+    }
+    atomic_init(&context.stopSweep, INT_MAX);
+    atomic_init(&context.lastSweep, 0);
+
+    if (pthread_barrier_init(&context.initBarrier, NULL,
+        (unsigned int) workers) != 0)
+    {
+        perror("pthread_barrier_init() error");
+        return RELAX_ERROR;
+    }
+
+    pthread_t threads[workers];
+    WavefrontArgs args[workers];
+
+    int status = RELAX_OK;
+    for (int i = 0; i < workers; i++)
+    {
+        args[i].context = &context;
+        args[i].tid = i;
+        // A single worker runs on the calling thread, as for the threaded
+        // method.
+        if (workers == 1)
+        {
+            wavefrontWorker(&args[i]);
+            break;
+        }
+        if (pthread_create(&threads[i], NULL, wavefrontWorker, &args[i]) != 0)
+        {
+            // The other workers would wait for this one forever.
+            perror("pthread_create() error");
+            exit(-1);
+        }
+    }
+
+    for (int i = 0; i < workers && workers > 1; i++)
+    {
+        if (pthread_join(threads[i], NULL) != 0)
+        {
+            perror("pthread_join() error");
+            status = RELAX_ERROR;
+        }
+    }
+    pthread_barrier_destroy(&context.initBarrier);
+
+    solver->iterations = atomic_load(&context.lastSweep);
+    if (status == RELAX_OK && atomic_load(&solver->cancelled))
+    {
+        status = RELAX_CANCELLED;
+    }
+    return status;
+}
+
+static void* wavefrontWorker(void* arg)
+{
+    WavefrontArgs* args = (WavefrontArgs*) arg;
+    WavefrontContext* context = args->context;
+    RelaxSolver* solver = context->solver;
+    int tid = args->tid;
+    int workers = solver->workers;
+
+    const GridExtents* extents = &solver->extents;
+    int rows = extents->rows;
+    int stackRows = rows * extents->planes;
+    bool volume = (extents->planes > 1);
+
+    int cpu = affinityCpuFor(&solver->affinity, tid);
+    if (cpu >= 0 && pinCurrentThread(cpu) != 0)
+    {
+        cpu = -1;
+    }
+
+    // First touch, as for the threaded method.
+    int firstRow = (int) ((long) tid * stackRows / workers);
+    int lastRow = (int) ((long) (tid + 1) * stackRows / workers);
+    initSolverRows(solver, solver->grid + ((long) firstRow * extents->columns),
+        firstRow, lastRow);
+
+    solver->placements[tid].cpu = cpu;
+    solver->placements[tid].firstRow = firstRow;
+    solver->placements[tid].lastRow = lastRow - 1;
+
+    int ok = pthread_barrier_wait(&context->initBarrier);
+    if (ok != 0 && ok != PTHREAD_BARRIER_SERIAL_THREAD)
+    {
+        perror("pthread_barrier_wait() error");
+        exit(-1);
+    }
+
+    // Relaxing a row reads the rows up to reach after it in the stack: the next
+    // row, and for volumes the same row in the next plane. The previous sweep
+    // must have finished those, and have finished reading this row, which it
+    // last does when relaxing the row reach after it.
+    int reach = volume ? rows : 1;
+    int columns = extents->columns;
+    long planeSize = (long) rows * columns;
+    InplaceRowKernel relaxRow = selectInplaceRow(solver->stencil);
+    InplaceRow3DKernel relaxVolumeRow = selectInplaceRow3D(solver->stencil);
+
+    atomic_long* mine = &context->progress[tid].position;
+    atomic_long* previous = &context->progress[(tid + workers - 1) %
+        workers].position;
+
+    for (int sweep = tid + 1; ; sweep += workers)
+    {
+        // Every sweep up to sweep - workers has finished, so this decision is
+        // the same however the threads are scheduled.
+        if (atomic_load_explicit(&context->stopSweep, memory_order_acquire) <=
+            sweep - workers)
+        {
+            break;
+        }
+
+        long base = (long) (sweep - 1) * stackRows;
+        long previousBase = base - stackRows;
+        double maxChange = 0.0;
+
+        for (int r = 1; r < stackRows - 1; r++)
+        {
+            int x = r % rows;
+            int z = r / rows;
+            bool boundary = (x == 0 || x == rows - 1 ||
+                (volume && (z == 0 || z == extents->planes - 1)));
+            if (!boundary)
+            {
+                long needed = r + reach + 1;
+                if (needed > stackRows)
+                {
+                    needed = stackRows;
+                }
+                waitForPosition(previous, previousBase + needed);
+
+                double* row = solver->grid + ((long) r * columns);
+                double change;
+                if (volume)
+                {
+                    change = relaxVolumeRow(row - planeSize, row - columns,
+                        row, row + columns, row + planeSize, 1, columns - 1,
+                        &solver->weights);
+                }
+                else
+                {
+                    change = relaxRow(row - columns, row, row + columns, 1,
+                        columns - 1, &solver->weights);
+                }
+                maxChange = fmax(maxChange, change);
+            }
+            // Boundary rows are published too, so the next sweep never waits
+            // for a row that is not relaxed.
+            atomic_store_explicit(mine, base + r + 1, memory_order_release);
+        }
+
+        // The previous sweep must have made its own decision first, so stops
+        // are seen in sweep order. That also keeps progress reports in order.
+        waitForPosition(previous, previousBase + stackRows);
+        raiseTo(&context->lastSweep, sweep);
+        if (reportProgress(solver, sweep, maxChange, 0.0) != 0 ||
+            maxChange <= solver->precision)
+        {
+            lowerTo(&context->stopSweep, sweep);
+        }
+        atomic_store_explicit(mine, base + stackRows, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Waits until the counter reaches the target. Spins first, as the previous
+// sweep is normally only a row or two ahead, then yields, in case it is
+// sharing this CPU.
+static void waitForPosition(atomic_long* position, long target)
+{
+    int spins = 0;
+    while (atomic_load_explicit(position, memory_order_acquire) < target)
+    {
+        if (++spins == WAVEFRONT_SPINS)
+        {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+static void lowerTo(atomic_int* value, int bound)
+{
+    int current = atomic_load(value);
+    while (bound < current &&
+        !atomic_compare_exchange_weak(value, &current, bound))
+    {
+    }
+}
+
+static void raiseTo(atomic_int* value, int bound)
+{
+    int current = atomic_load(value);
+    while (bound > current &&
+        !atomic_compare_exchange_weak(value, &current, bound))
+    {
+    }
+}
@@ -0,0 +1,324 @@
+/**
+ * @file stencil.h
+ * @brief Header-only stencil engine shared by every solver.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * The solvers are C, so the engine is written as generator macros rather than
+ * templates. Each macro stamps out a static inline kernel for one combination
+ * of:
+ *   - stencil shape: STENCIL_5_POINT, STENCIL_9_POINT or STENCIL_WEIGHTED in
+ *     2D, and STENCIL_7_POINT in 3D,
+ *   - scalar type: any floating point type, e.g. double or float,
+ *   - width: an optional compile-time width of the row segment, or of the
+ *     whole grid for the fixed-size sweep,
+ *   - fields: for the multi-field kernels, an optional compile-time number of
+ *     boundary configurations interleaved per cell.
+ * The shape, type and trip counts are all known to the compiler, so each
+ * instantiation can be fully unrolled, and the Jacobi kernels vectorised, on
+ * its own.
+ *
+ * Rows are passed as separate pointers (up, row, down), so the same kernels
+ * work on a whole grid, on an MPI slab with halo rows, or on a single tile.
+ * The 3D kernels also take the matching rows of the planes in front and
+ * behind.
+ *
+ * Example, a Jacobi row kernel for doubles with a 5-point stencil:
+ *
+ *     STENCIL_DEFINE_JACOBI_ROW(jacobiRow5, double, STENCIL_5_POINT, 0)
+ *
+ *     double maxChange = jacobiRow5(out, up, row, down, 1, dimension - 1,
+ *         &weights);
+ */
+
+#pragma once
+
+#include <tgmath.h>
+
+
+// Coefficients of the weighted stencil, which averages the vertical and
+// horizontal neighbours with separate weights. Use stencilWeights to build
+// them, so they always sum to one.
+typedef struct
+{
+    double vertical;
+    double horizontal;
+} StencilWeights;
+
+// Normalises the weight of the vertical and horizontal neighbour pairs. Equal
+// weights give the plain 5-point average.
+static inline StencilWeights stencilWeights(double verticalWeight,
+    double horizontalWeight)
+{
+    StencilWeights weights;
+    double total = 2.0 * (verticalWeight + horizontalWeight);
+    weights.vertical = verticalWeight / total;
+    weights.horizontal = horizontalWeight / total;
+    return weights;
+}
+
+
+// Shapes. Each evaluates the new value of cell y of row, given the rows above
+// and below. Neighbouring cells of a row are step values apart: 1 for a plain
+// grid, or the number of fields when several are interleaved per cell. The
+// 5-point sum is kept in the order the solvers have always used, so results
+// are unchanged bit for bit.
+#define STENCIL_5_POINT(T, up, row, down, y, step, weights) \
+    ((up[y] + down[y] + row[(y) - (step)] + row[(y) + (step)]) / (T) 4.0)
+
+// The compact 9-point (Mehrstellen) Laplacian: edge neighbours weigh 4, corner
+// neighbours weigh 1.
+#define STENCIL_9_POINT(T, up, row, down, y, step, weights) \
+    ((((T) 4.0 * (up[y] + down[y] + row[(y) - (step)] + \
+    row[(y) + (step)])) + up[(y) - (step)] + up[(y) + (step)] + \
+    down[(y) - (step)] + down[(y) + (step)]) / (T) 20.0)
+
+#define STENCIL_WEIGHTED(T, up, row, down, y, step, weights) \
+    (((T) (weights)->vertical * (up[y] + down[y])) + \
+    ((T) (weights)->horizontal * (row[(y) - (step)] + row[(y) + (step)])))
+
+// 3D shapes also read the rows in the neighbouring planes. The 7-point stencil
+// averages the six face neighbours.
+#define STENCIL_7_POINT(T, front, up, row, down, back, y, step, weights) \
+    ((up[y] + down[y] + row[(y) - (step)] + row[(y) + (step)] + front[y] + \
+    back[y]) / (T) 6.0)
+
+// Type-generic through tgmath.h. The kernels use fmax rather than a comparison,
+// which the compiler can turn into a vectorised reduction when NaNs are ruled
+// out (see relax_kernels.c).
+#define STENCIL_ABS(T, value) fabs((T) (value))
+#define STENCIL_MAX(a, b) fmax(a, b)
+
+
+// Jacobi row kernel: reads up/row/down, writes out, over cells [begin, end).
+// Returns the largest change. Inputs and output must not overlap, which lets
+// the loop vectorise. With a WIDTH above zero, the row is processed in blocks
+// of WIDTH cells with a constant trip count, plus a remainder.
+#define STENCIL_DEFINE_JACOBI_ROW(NAME, T, SHAPE, WIDTH) \
+    static inline T NAME(T* restrict out, const T* restrict up, \
+        const T* restrict row, const T* restrict down, int begin, int end, \
+        const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        int y = begin; \
+        if ((WIDTH) > 0) \
+        { \
+            for (; y + (WIDTH) <= end; y += (WIDTH)) \
+            { \
+                for (int w = 0; w < (WIDTH); w++) \
+                { \
+                    T value = SHAPE(T, up, row, down, y + w, 1, weights); \
+                    T change = STENCIL_ABS(T, value - row[y + w]); \
+                    maxChange = STENCIL_MAX(maxChange, change); \
+                    out[y + w] = value; \
+                } \
+            } \
+        } \
+        for (; y < end; y++) \
+        { \
+            T value = SHAPE(T, up, row, down, y, 1, weights); \
+            T change = STENCIL_ABS(T, value - row[y]); \
+            maxChange = STENCIL_MAX(maxChange, change); \
+            out[y] = value; \
+        } \
+        return maxChange; \
+    }
+
+// In-place (Gauss-Seidel) row kernel: updates row over cells [begin, end),
+// using values already updated on the left and in the row above. Returns the
+// largest change. The loop carries a dependency, so it is unrolled but not
+// vectorised.
+#define STENCIL_DEFINE_INPLACE_ROW(NAME, T, SHAPE) \
+    static inline T NAME(const T* up, T* row, const T* down, int begin, \
+        int end, const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        for (int y = begin; y < end; y++) \
+        { \
+            T value = SHAPE(T, up, row, down, y, 1, weights); \
+            T change = STENCIL_ABS(T, value - row[y]); \
+            maxChange = STENCIL_MAX(maxChange, change); \
+            row[y] = value; \
+        } \
+        return maxChange; \
+    }
+
+// Fixed-size Jacobi sweep over the interior of an N x N grid, from in to out.
+// Every bound is a compile-time constant, so small grids get a fully
+// specialised loop nest. Returns the largest change.
+#define STENCIL_DEFINE_FIXED_JACOBI(NAME, T, SHAPE, N) \
+    static inline T NAME(T* restrict out, const T* restrict in, \
+        const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        for (int x = 1; x < (N) - 1; x++) \
+        { \
+            const T* up = in + ((x - 1) * (N)); \
+            const T* row = in + (x * (N)); \
+            const T* down = in + ((x + 1) * (N)); \
+            T* target = out + (x * (N)); \
+            for (int y = 1; y < (N) - 1; y++) \
+            { \
+                T value = SHAPE(T, up, row, down, y, 1, weights); \
+                T change = STENCIL_ABS(T, value - row[y]); \
+                maxChange = STENCIL_MAX(maxChange, change); \
+                target[y] = value; \
+            } \
+        } \
+        return maxChange; \
+    }
+
+// Fixed-size in-place (Gauss-Seidel) sweep over the interior of an N x N grid.
+// Returns the largest change.
+#define STENCIL_DEFINE_FIXED_INPLACE(NAME, T, SHAPE, N) \
+    static inline T NAME(T* grid, const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        for (int x = 1; x < (N) - 1; x++) \
+        { \
+            const T* up = grid + ((x - 1) * (N)); \
+            T* row = grid + (x * (N)); \
+            const T* down = grid + ((x + 1) * (N)); \
+            for (int y = 1; y < (N) - 1; y++) \
+            { \
+                T value = SHAPE(T, up, row, down, y, 1, weights); \
+                T change = STENCIL_ABS(T, value - row[y]); \
+                maxChange = STENCIL_MAX(maxChange, change); \
+                row[y] = value; \
+            } \
+        } \
+        return maxChange; \
+    }
+
+// 3D Jacobi row kernel, as STENCIL_DEFINE_JACOBI_ROW with the rows of the
+// planes in front and behind as extra inputs.
+#define STENCIL_DEFINE_JACOBI_ROW_3D(NAME, T, SHAPE, WIDTH) \
+    static inline T NAME(T* restrict out, const T* restrict front, \
+        const T* restrict up, const T* restrict row, const T* restrict down, \
+        const T* restrict back, int begin, int end, \
+        const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        int y = begin; \
+        if ((WIDTH) > 0) \
+        { \
+            for (; y + (WIDTH) <= end; y += (WIDTH)) \
+            { \
+                for (int w = 0; w < (WIDTH); w++) \
+                { \
+                    T value = SHAPE(T, front, up, row, down, back, y + w, \
+                        1, weights); \
+                    T change = STENCIL_ABS(T, value - row[y + w]); \
+                    maxChange = STENCIL_MAX(maxChange, change); \
+                    out[y + w] = value; \
+                } \
+            } \
+        } \
+        for (; y < end; y++) \
+        { \
+            T value = SHAPE(T, front, up, row, down, back, y, 1, \
+                weights); \
+            T change = STENCIL_ABS(T, value - row[y]); \
+            maxChange = STENCIL_MAX(maxChange, change); \
+            out[y] = value; \
+        } \
+        return maxChange; \
+    }
+
+// 3D in-place (Gauss-Seidel) row kernel.
+#define STENCIL_DEFINE_INPLACE_ROW_3D(NAME, T, SHAPE) \
+    static inline T NAME(const T* front, const T* up, T* row, const T* down, \
+        const T* back, int begin, int end, const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        T maxChange = (T) 0; \
+        for (int y = begin; y < end; y++) \
+        { \
+            T value = SHAPE(T, front, up, row, down, back, y, 1, \
+                weights); \
+            T change = STENCIL_ABS(T, value - row[y]); \
+            maxChange = STENCIL_MAX(maxChange, change); \
+            row[y] = value; \
+        } \
+        return maxChange; \
+    }
+
+// Multi-field Jacobi row kernel. The rows hold the same grid under several
+// boundary configurations, FIELDS values per cell interleaved (field f of cell
+// y at y * FIELDS + f). Relaxes cells [begin, end) of every field from
+// up/row/down into out, and raises changes[f] to the largest change of field
+// f. The inner loop runs across the fields and the changes are kept in a local
+// array, so with a compile-time FIELDS it unrolls completely, the changes stay
+// in registers, and it vectorises with a field per lane.
+// A FIELDS of 0 takes the count from fields at run time instead, which must
+// then be at most STENCIL_MAX_FIELDS.
+#define STENCIL_MAX_FIELDS 64
+
+#define STENCIL_DEFINE_FIELDS_JACOBI_ROW(NAME, T, SHAPE, FIELDS) \
+    static inline void NAME(T* restrict out, const T* restrict up, \
+        const T* restrict row, const T* restrict down, int begin, int end, \
+        int fields, T* restrict changes, const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        const int count = (FIELDS) > 0 ? (FIELDS) : fields; \
+        T local[(FIELDS) > 0 ? (FIELDS) : STENCIL_MAX_FIELDS]; \
+        for (int f = 0; f < count; f++) \
+        { \
+            local[f] = changes[f]; \
+        } \
+        for (int y = begin; y < end; y++) \
+        { \
+            _Pragma("GCC unroll 16") \
+            for (int f = 0; f < count; f++) \
+            { \
+                int i = (y * count) + f; \
+                T value = SHAPE(T, up, row, down, i, count, weights); \
+                T change = STENCIL_ABS(T, value - row[i]); \
+                local[f] = STENCIL_MAX(local[f], change); \
+                out[i] = value; \
+            } \
+        } \
+        for (int f = 0; f < count; f++) \
+        { \
+            changes[f] = local[f]; \
+        } \
+    }
+
+// 3D multi-field Jacobi row kernel, as STENCIL_DEFINE_FIELDS_JACOBI_ROW with
+// the rows of the planes in front and behind as extra inputs.
+#define STENCIL_DEFINE_FIELDS_JACOBI_ROW_3D(NAME, T, SHAPE, FIELDS) \
+    static inline void NAME(T* restrict out, const T* restrict front, \
+        const T* restrict up, const T* restrict row, const T* restrict down, \
+        const T* restrict back, int begin, int end, int fields, \
+        T* restrict changes, const StencilWeights* weights) \
+    { \
+        (void) weights; \
+        const int count = (FIELDS) > 0 ? (FIELDS) : fields; \
+        T local[(FIELDS) > 0 ? (FIELDS) : STENCIL_MAX_FIELDS]; \
+        for (int f = 0; f < count; f++) \
+        { \
+            local[f] = changes[f]; \
+        } \
+        for (int y = begin; y < end; y++) \
+        { \
+            _Pragma("GCC unroll 16") \
+            for (int f = 0; f < count; f++) \
+            { \
+                int i = (y * count) + f; \
+                T value = SHAPE(T, front, up, row, down, back, i, count, \
+                    weights); \
+                T change = STENCIL_ABS(T, value - row[i]); \
+                local[f] = STENCIL_MAX(local[f], change); \
+                out[i] = value; \
+            } \
+        } \
+        for (int f = 0; f < count; f++) \
+        { \
+            changes[f] = local[f]; \
+        } \
+    }
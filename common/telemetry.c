@@ -0,0 +1,288 @@
+/**
+ * @file telemetry.c
+ * @brief Source utility file for the telemetry stream: per-sweep progress of a
+ * solve, passed through a lock-free ring to a background writer.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Pushing a record costs a clock read and a few stores, so it can sit in the
+ * sweep loop. The writer thread wakes every TELEMETRY_INTERVAL_NS, formats
+ * whatever has arrived and writes it out, one line per sweep:
+ *
+ *     SWEEP RESIDUAL SWEEPSECONDS SKEW ETASECONDS
+ *
+ * The residual is the largest change of the sweep. Relaxation shrinks it by a
+ * roughly constant factor per sweep, so the writer keeps a moving average of
+ * that factor and of the sweep time, and extrapolates how long the residual
+ * takes to reach the precision. The ETA is "-" until the residual is shrinking.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+
+#define TELEMETRY_INTERVAL_NS 10000000L
+
+// Weight of the newest sweep in the moving averages.
+#define TELEMETRY_SMOOTHING 0.1
+
+
+// Function declarations
+static void* telemetryWriter(void* arg);
+static void drainRecords(Telemetry* telemetry);
+static void writeLine(Telemetry* telemetry, const char* line);
+static int openDestination(const char* destination, bool* isSocket);
+static double secondsSince(const struct timespec* start);
+
+
+// Function definitions
+Telemetry* startTelemetry(const char* destination, const char* header,
+    double precision)
+{
+    Telemetry* telemetry = (Telemetry*) calloc(1, sizeof(Telemetry));
+    if (telemetry == NULL)
+    {
+        perror("calloc() error");
+        return NULL;
+    }
+
+    telemetry->fd = openDestination(destination, &telemetry->socket);
+    if (telemetry->fd < 0)
+    {
+        free(telemetry);
+        return NULL;
+    }
+
+    atomic_init(&telemetry->head, 0);
+    atomic_init(&telemetry->tail, 0);
+    atomic_init(&telemetry->dropped, 0);
+    atomic_init(&telemetry->stopping, 0);
+    telemetry->precision = precision;
+    clock_gettime(CLOCK_MONOTONIC, &telemetry->start);
+
+    char line[256];
+    snprintf(line, sizeof(line),
+        "# %s\n# SWEEP RESIDUAL SWEEPSECONDS SKEW ETASECONDS\n", header);
+    writeLine(telemetry, line);
+
+    if (pthread_create(&telemetry->writer, NULL, telemetryWriter,
+        telemetry) != 0)
+    {
+        perror("pthread_create() error");
+        close(telemetry->fd);
+        free(telemetry);
+        return NULL;
+    }
+    return telemetry;
+}
+
+void recordTelemetry(Telemetry* telemetry, int iteration, double maxChange,
+    double skew)
+{
+    telemetry->lastIteration = iteration;
+    unsigned long head = atomic_load_explicit(&telemetry->head,
+        memory_order_acquire);
+    unsigned long tail = atomic_load_explicit(&telemetry->tail,
+        memory_order_acquire);
+    if (head - tail >= TELEMETRY_RING_SIZE)
+    {
+        atomic_fetch_add_explicit(&telemetry->dropped, 1,
+            memory_order_relaxed);
+        return;
+    }
+
+    TelemetryRecord* record = &telemetry->records[head &
+        (TELEMETRY_RING_SIZE - 1)];
+    record->iteration = iteration;
+    record->maxChange = maxChange;
+    record->skew = skew;
+    record->time = secondsSince(&telemetry->start);
+    atomic_store_explicit(&telemetry->head, head + 1, memory_order_release);
+}
+
+void stopTelemetry(Telemetry* telemetry)
+{
+    if (telemetry == NULL)
+    {
+        return;
+    }
+
+    atomic_store(&telemetry->stopping, 1);
+    if (pthread_join(telemetry->writer, NULL) != 0)
+    {
+        perror("pthread_join() error");
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "# finished after %d sweeps in %f s, "
+        "%lu records dropped\n", telemetry->lastIteration,
+        secondsSince(&telemetry->start),
+        atomic_load(&telemetry->dropped));
+    writeLine(telemetry, line);
+
+    close(telemetry->fd);
+    free(telemetry);
+}
+
+static void* telemetryWriter(void* arg)
+{
+    Telemetry* telemetry = (Telemetry*) arg;
+    struct timespec interval = { 0, TELEMETRY_INTERVAL_NS };
+
+    while (!atomic_load(&telemetry->stopping))
+    {
+        drainRecords(telemetry);
+        nanosleep(&interval, NULL);
+    }
+    // Anything pushed before the stop.
+    drainRecords(telemetry);
+    return NULL;
+}
+
+// Pops and writes every record in the ring.
+static void drainRecords(Telemetry* telemetry)
+{
+    unsigned long tail = atomic_load_explicit(&telemetry->tail,
+        memory_order_relaxed);
+    unsigned long head = atomic_load_explicit(&telemetry->head,
+        memory_order_acquire);
+
+    for (; tail != head; tail++)
+    {
+        TelemetryRecord record = telemetry->records[tail &
+            (TELEMETRY_RING_SIZE - 1)];
+        // The slot may be reused once the tail has passed it.
+        atomic_store_explicit(&telemetry->tail, tail + 1,
+            memory_order_release);
+
+        // Dropped records leave gaps, so rates are per sweep, not per record.
+        TelemetryRecord* last = &telemetry->last;
+        int sweeps = record.iteration - last->iteration;
+        if (telemetry->primed && sweeps > 0)
+        {
+            double seconds = (record.time - last->time) / sweeps;
+            telemetry->sweepSeconds += TELEMETRY_SMOOTHING *
+                (seconds - telemetry->sweepSeconds);
+            if (record.maxChange > 0.0 && last->maxChange > 0.0)
+            {
+                double rate = log(record.maxChange / last->maxChange) / sweeps;
+                telemetry->logRate += TELEMETRY_SMOOTHING *
+                    (rate - telemetry->logRate);
+            }
+        }
+        else if (!telemetry->primed)
+        {
+            telemetry->sweepSeconds = record.time / (record.iteration > 0 ?
+                record.iteration : 1);
+            telemetry->primed = true;
+        }
+        *last = record;
+
+        char eta[32] = "-";
+        if (record.maxChange <= telemetry->precision)
+        {
+            strcpy(eta, "0");
+        }
+        else if (telemetry->logRate < 0.0 && telemetry->precision > 0.0)
+        {
+            double remaining = log(telemetry->precision / record.maxChange) /
+                telemetry->logRate;
+            snprintf(eta, sizeof(eta), "%.3f",
+                remaining * telemetry->sweepSeconds);
+        }
+
+        char line[160];
+        snprintf(line, sizeof(line), "%d %.6e %.6e %.6e %s\n",
+            record.iteration, record.maxChange, telemetry->sweepSeconds,
+            record.skew, eta);
+        writeLine(telemetry, line);
+    }
+}
+
+// Writes the whole line. After a failed write, for example a monitor that hung
+// up, the stream goes quiet rather than failing the solve.
+static void writeLine(Telemetry* telemetry, const char* line)
+{
+    size_t length = strlen(line);
+    while (length > 0 && !telemetry->broken)
+    {
+        ssize_t written;
+        if (telemetry->socket)
+        {
+            written = send(telemetry->fd, line, length, MSG_NOSIGNAL);
+        }
+        else
+        {
+            written = write(telemetry->fd, line, length);
+        }
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("telemetry write error");
+            telemetry->broken = true;
+            return;
+        }
+        line += written;
+        length -= (size_t) written;
+    }
+}
+
+static int openDestination(const char* destination, bool* isSocket)
+{
+    *isSocket = (strncmp(destination, "unix:", 5) == 0);
+    if (!*isSocket)
+    {
+        int fd = open(destination, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+            0644);
+        if (fd < 0)
+        {
+            perror("telemetry open() error");
+        }
+        return fd;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    const char* path = destination + 5;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Telemetry socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        perror("telemetry socket() error");
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0)
+    {
+        perror("telemetry connect() error");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        ((double) (now.tv_nsec - start->tv_nsec) / 1e9);
+}
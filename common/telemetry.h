@@ -0,0 +1,72 @@
+/**
+ * @file telemetry.h
+ * @brief Header utility file for the telemetry stream: per-sweep progress of a
+ * solve, passed through a lock-free ring to a background writer.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <time.h>
+
+
+// Records the ring holds. A power of two, so positions wrap with a mask.
+#define TELEMETRY_RING_SIZE 1024
+
+typedef struct
+{
+    int iteration;
+    double maxChange;
+    double skew;
+    // Seconds since the stream started.
+    double time;
+} TelemetryRecord;
+
+// Single producer, single consumer: the thread reporting progress pushes
+// records, and the writer thread pops them. Neither ever waits for the other;
+// a record that does not fit is dropped and counted instead.
+typedef struct
+{
+    TelemetryRecord records[TELEMETRY_RING_SIZE];
+    // Next record to push and to pop. Each has a cache line to itself, so the
+    // producer and the writer do not invalidate each other's.
+    _Alignas(64) atomic_ulong head;
+    // Last sweep pushed, whether or not it fitted. Producer only.
+    int lastIteration;
+    _Alignas(64) atomic_ulong tail;
+    atomic_ulong dropped;
+    atomic_int stopping;
+    struct timespec start;
+
+    // Writer thread state.
+    pthread_t writer;
+    int fd;
+    bool socket;
+    bool broken;
+    double precision;
+    TelemetryRecord last;
+    bool primed;
+    // Moving averages of the log of the change per sweep, and of the seconds
+    // per sweep, from which the time to converge is extrapolated.
+    double logRate;
+    double sweepSeconds;
+} Telemetry;
+
+
+// Opens destination, a file path or "unix:PATH" for a Unix stream socket,
+// writes the header line and starts the writer thread. Returns NULL, having
+// printed why, if the destination cannot be opened.
+Telemetry* startTelemetry(const char* destination, const char* header,
+    double precision);
+
+// Pushes a record without blocking. Only one thread may push at a time.
+void recordTelemetry(Telemetry* telemetry, int iteration, double maxChange,
+    double skew);
+
+// Writes out every record pushed so far, stops the writer and frees the
+// stream.
+void stopTelemetry(Telemetry* telemetry);
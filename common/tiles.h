@@ -0,0 +1,45 @@
+/**
+ * @file tiles.h
+ * @brief Header utility file for the tile activity map, which lets sweeps skip
+ * regions of the grid that have already settled.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "arena.h"
+
+
+typedef struct
+{
+    int tileSize;
+    int tilesDown;
+    int tilesAcross;
+    // A tile is swept if it, or one of its four neighbours, changed by at
+    // least this much in the last sweep. Negative keeps every tile active.
+    double threshold;
+    // Largest change of each tile in the current sweep.
+    double* change;
+    bool* active;
+} TileMap;
+
+
+size_t tileMapArenaSize(int rows, int columns, int tileSize);
+
+int createTileMap(TileMap* map, Arena* arena, int rows, int columns,
+    int tileSize, double threshold);
+
+void wakeAllTiles(TileMap* map);
+
+int selectActiveTiles(TileMap* map);
+
+// Index of the tile holding interior cell (x, y), for x, y >= 1.
+static inline int tileIndex(const TileMap* map, int x, int y)
+{
+    return (((x - 1) / map->tileSize) * map->tilesAcross) +
+        ((y - 1) / map->tileSize);
+}
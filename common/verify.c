@@ -0,0 +1,188 @@
+/**
+ * @file verify.c
+ * @brief Source utility file for the verification harnesses: comparing a
+ * result with the reference in memory, and timing cases against a stored
+ * baseline.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "verify.h"
+
+
+// Function definitions
+void compareGrids(const double* result, const double* reference, size_t cells,
+    VerifyErrors* errors)
+{
+    double maxError = 0.0;
+    double sumSquares = 0.0;
+    for (size_t i = 0; i < cells; i++)
+    {
+        double error = fabs(result[i] - reference[i]);
+        // NaN compares false, so it has to be caught explicitly.
+        if (error > maxError || isnan(error))
+        {
+            maxError = error;
+        }
+        sumSquares += error * error;
+    }
+    errors->maxError = maxError;
+    errors->rmsError = cells > 0 ? sqrt(sumSquares / (double) cells) : 0.0;
+}
+
+int loadBaseline(Baseline* baseline, const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (file == NULL)
+    {
+        if (errno == ENOENT)
+        {
+            return 0;
+        }
+        perror("fopen() error");
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        char name[64];
+        double seconds;
+        if (line[0] == '#' || sscanf(line, "%63s %lf", name, &seconds) != 2 ||
+            seconds <= 0.0)
+        {
+            continue;
+        }
+        if (recordBaseline(baseline, name, seconds) != 0)
+        {
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+double baselineSeconds(const Baseline* baseline, const char* name)
+{
+    for (int i = 0; i < baseline->count; i++)
+    {
+        if (strcmp(baseline->entries[i].name, name) == 0)
+        {
+            return baseline->entries[i].seconds;
+        }
+    }
+    return -1.0;
+}
+
+int recordBaseline(Baseline* baseline, const char* name, double seconds)
+{
+    for (int i = 0; i < baseline->count; i++)
+    {
+        if (strcmp(baseline->entries[i].name, name) == 0)
+        {
+            baseline->entries[i].seconds = seconds;
+            return 0;
+        }
+    }
+
+    if (baseline->count == baseline->capacity)
+    {
+        int capacity = baseline->capacity > 0 ? baseline->capacity * 2 : 64;
+        BaselineEntry* entries = (BaselineEntry*) realloc(baseline->entries,
+            (size_t) capacity * sizeof(BaselineEntry));
+        if (entries == NULL)
+        {
+            perror("realloc() error");
+            return -1;
+        }
+        baseline->entries = entries;
+        baseline->capacity = capacity;
+    }
+
+    BaselineEntry* entry = &baseline->entries[baseline->count++];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->seconds = seconds;
+    return 0;
+}
+
+int saveBaseline(const Baseline* baseline, const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror("fopen() error");
+        return -1;
+    }
+    fprintf(file, "# NAME SECONDS\n");
+    for (int i = 0; i < baseline->count; i++)
+    {
+        fprintf(file, "%s %.6f\n", baseline->entries[i].name,
+            baseline->entries[i].seconds);
+    }
+    fclose(file);
+    return 0;
+}
+
+void freeBaseline(Baseline* baseline)
+{
+    free(baseline->entries);
+    baseline->entries = NULL;
+    baseline->count = 0;
+    baseline->capacity = 0;
+}
+
+int reportCase(const char* name, const VerifyErrors* errors, double seconds,
+    const Baseline* baseline, const VerifyOptions* options)
+{
+    int outcome = 0;
+    if (!(errors->maxError <= options->maxTolerance &&
+        errors->rmsError <= options->rmsTolerance))
+    {
+        outcome |= VERIFY_WRONG;
+    }
+
+    char timing[64] = "";
+    double expected = baseline != NULL ? baselineSeconds(baseline, name) : -1.0;
+    if (expected > 0.0)
+    {
+        double change = (seconds / expected) - 1.0;
+        snprintf(timing, sizeof(timing), " (baseline %.4f s, %+.0f%%)",
+            expected, change * 100.0);
+        if (change > options->threshold)
+        {
+            outcome |= VERIFY_SLOWER;
+        }
+    }
+
+    const char* verdict = "OK";
+    if (outcome & VERIFY_WRONG)
+    {
+        verdict = "WRONG";
+    }
+    else if (outcome & VERIFY_SLOWER)
+    {
+        verdict = "SLOWER";
+    }
+    printf("%-44s max %.2e rms %.2e %9.4f s%s %s\n", name, errors->maxError,
+        errors->rmsError, seconds, timing, verdict);
+    fflush(stdout);
+    return outcome;
+}
+
+int finishVerify(int cases, int wrong, int slower)
+{
+    printf("\n%d cases: %d wrong, %d slower than the baseline\n", cases, wrong,
+        slower);
+    if (wrong > 0)
+    {
+        return 1;
+    }
+    return slower > 0 ? 2 : 0;
+}
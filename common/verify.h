@@ -0,0 +1,82 @@
+/**
+ * @file verify.h
+ * @brief Header utility file for the verification harnesses: comparing a
+ * result with the reference in memory, and timing cases against a stored
+ * baseline.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+// Outcome of a case, as bits, so a run can report both at once.
+#define VERIFY_WRONG 1
+#define VERIFY_SLOWER 2
+
+typedef struct
+{
+    // Largest absolute difference from the reference (L-infinity).
+    double maxError;
+    // Root mean square difference from the reference (L2, per cell).
+    double rmsError;
+} VerifyErrors;
+
+typedef struct
+{
+    char name[64];
+    double seconds;
+} BaselineEntry;
+
+// Seconds per case name, read from and written to a text file with a line per
+// case:
+//
+//     NAME SECONDS
+//
+// Lines starting with '#' are ignored.
+typedef struct
+{
+    BaselineEntry* entries;
+    int count;
+    int capacity;
+} Baseline;
+
+typedef struct
+{
+    double maxTolerance;
+    double rmsTolerance;
+    // A case is slower when it takes more than this fraction longer than its
+    // baseline.
+    double threshold;
+    // Solves per case; the fastest is the one timed.
+    int repeats;
+} VerifyOptions;
+
+
+void compareGrids(const double* result, const double* reference, size_t cells,
+    VerifyErrors* errors);
+
+// A missing file is an empty baseline. Returns -1 if the file is unreadable.
+int loadBaseline(Baseline* baseline, const char* path);
+
+// Returns the seconds recorded for name, or a negative value if none are.
+double baselineSeconds(const Baseline* baseline, const char* name);
+
+// Adds or replaces the seconds recorded for name.
+int recordBaseline(Baseline* baseline, const char* name, double seconds);
+
+int saveBaseline(const Baseline* baseline, const char* path);
+
+void freeBaseline(Baseline* baseline);
+
+// Prints a line for the case and returns its outcome bits. A case without a
+// baseline, or with baseline NULL, is never slower.
+int reportCase(const char* name, const VerifyErrors* errors, double seconds,
+    const Baseline* baseline, const VerifyOptions* options);
+
+// Prints the totals and returns the exit status of the harness: 0 if every
+// case passed, 1 if any was wrong, otherwise 2 if any was slower.
+int finishVerify(int cases, int wrong, int slower);
@@ -4,46 +4,91 @@
  * @date 29/12/2021
  * @author dancs-dev
  *
- * Compile using:
- * mpicc -Wall -Wextra -o distributed-memory.o main.c matrix.c
+ * Compile using (after building librelax with mpicc, see the README):
+ * mpicc -Wall -Wextra -o distributed-memory.o main.c -L../common -lrelax_mpi
+ * -lpthread -lm
  *
  * Run using: mpirun ./distributed-memory.o -a ARRAYSIZE -p PRECISION
+ * [-x ROWS -y COLUMNS -z PLANES] [-c compact|scatter|CPULIST]
+ * [-k 5|9|weighted:V,H] [-r INTERVAL] [-T FILE|unix:PATH]
+ * [-m jacobi|direct|chebyshev|chebyshev:adaptive]
+ * [-B TOP,LEFT,BOTTOM,RIGHT[,FRONT,BACK] ...]
  * Example: mpirun ./distributed-memory.o -a 10 -p 0.001
  *
- * The array size must be greater than the number of processors used.
+ * -a sets a square grid; -x and -y set the rows and columns separately, and
+ * -z above 1 relaxes a volume of that many planes with the 7-point stencil.
+ * Grids are split into slabs of rows, and volumes into slabs of planes, with
+ * the interior rows (planes) shared out evenly. There must be at least one
+ * interior row (plane) per processor.
+ *
+ * The optional -c flag pins each rank, including any helper threads the MPI
+ * library has started, to a CPU. The rank's position on its node is used to
+ * pick the CPU, so each node hands out its own CPUs from the start.
+ *
+ * The optional -k flag picks the stencil, as for the shared memory program.
+ *
+ * The optional -m chebyshev flag accelerates the Jacobi sweeps with Chebyshev
+ * semi-iteration, from the spectral radius of the grid, or with
+ * chebyshev:adaptive from the observed convergence rate. Rank 0 reports how
+ * many sweeps plain Jacobi would have needed.
+ *
+ * The optional -m direct flag solves the grid exactly with discrete sine
+ * transforms instead of relaxing it: each rank transforms a band of rows, and
+ * two all-to-all transposes move the columns between ranks. 2D only.
+ *
+ * The optional -r flag rebalances the slabs every INTERVAL sweeps: ranks that
+ * took longer to relax their slab hand rows to their faster neighbours. Use it
+ * when the nodes are uneven or shared.
+ *
+ * The optional -B flag, given once per field, solves the grid under several
+ * boundary configurations at once, as for the shared memory program: each
+ * halo exchange carries every field still converging, and rank 0 prints each
+ * field's result with the sweeps it took. Fields are relaxed by the plain
+ * Jacobi sweeps, so they cannot be combined with -m direct, -m chebyshev or
+ * -r.
+ *
+ * The optional -T flag streams progress from rank 0, a line per sweep, to FILE
+ * or to the Unix socket at PATH: the residual, the sweep time, the skew (the
+ * seconds between the fastest and slowest rank) and the estimated time left.
+ *
+ * The solver itself lives in librelax; this program only parses the command
+ * line and prints the result.
  *
  */
 
 #include <mpi.h>
-#include <math.h>
 #include <stdio.h>
 #include <stdbool.h>
-#include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <string.h>
+#include <unistd.h>
 
-#include "matrix.h"
+#include "../common/matrix.h"
+#include "../common/relax.h"
+#include "../common/relax_mpi.h"
 
 
 // Default settings
 double PRECISION    = 0.001;
-int ARRAY_DIMENSION = 30;
-
+int ROWS            = 30;
+int COLUMNS         = 30;
+int PLANES          = 1;
+int FIELD_COUNT     = 0;
+RelaxBoundaries FIELDS[RELAX_MAX_FIELDS];
 
-// Global variables (actually private to each process, as we are on distrubted
-// memory using MPI).
-double* doubleMatrix;
-
-// Function declarations
-double averageNeighbours(double* matrix, int x, int y);
 
 int main(int argc, char** argv)
 {
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return -1;
+    }
+
     while(true)
     {
         int c;
-        c = getopt(argc, argv, "a:p:");
+        c = getopt(argc, argv, "a:x:y:z:p:c:k:r:m:T:B:");
         if (c == -1)
         {
             break;
@@ -51,12 +96,40 @@ int main(int argc, char** argv)
         switch(c)
         {
             case 'a':
-                ARRAY_DIMENSION = atoi(optarg);
-                if (ARRAY_DIMENSION < 3)
+                ROWS = atoi(optarg);
+                COLUMNS = ROWS;
+                if (ROWS < 3)
                 {
                     return -1;
                 }
-                printf("Set array dimension to: %d\n", ARRAY_DIMENSION);
+                printf("Set array dimension to: %d\n", ROWS);
+                break;
+
+            case 'x':
+                ROWS = atoi(optarg);
+                if (ROWS < 3)
+                {
+                    return -1;
+                }
+                printf("Set rows to: %d\n", ROWS);
+                break;
+
+            case 'y':
+                COLUMNS = atoi(optarg);
+                if (COLUMNS < 3)
+                {
+                    return -1;
+                }
+                printf("Set columns to: %d\n", COLUMNS);
+                break;
+
+            case 'z':
+                PLANES = atoi(optarg);
+                if (PLANES < 1 || PLANES == 2)
+                {
+                    return -1;
+                }
+                printf("Set planes to: %d\n", PLANES);
                 break;
 
             case 'p':
@@ -67,272 +140,149 @@ int main(int argc, char** argv)
                 }
                 printf("Set precision to: %f\n", PRECISION);
                 break;
+
+            case 'c':
+                if (relaxSetAffinity(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set affinity to: %s\n", relaxGetAffinityName(solver));
+                break;
+
+            case 'k':
+                if (relaxSetStencilByName(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set stencil to: %s\n", optarg);
+                break;
+
+            case 'm':
+                if ((strcmp(optarg, "jacobi") != 0 &&
+                    strcmp(optarg, "direct") != 0 &&
+                    strncmp(optarg, "chebyshev", 9) != 0) ||
+                    relaxSetMethodByName(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set method to: %s\n", optarg);
+                break;
+
+            case 'r':
+                if (relaxSetRebalance(solver, atoi(optarg)) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set rebalance interval to: %s\n", optarg);
+                break;
+
+            case 'T':
+                if (relaxSetTelemetry(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set telemetry to: %s\n", optarg);
+                break;
+
+            case 'B':
+                if (FIELD_COUNT == RELAX_MAX_FIELDS ||
+                    relaxParseBoundaries(optarg, &FIELDS[FIELD_COUNT]) !=
+                    RELAX_OK)
+                {
+                    return -1;
+                }
+                FIELD_COUNT++;
+                printf("Set boundaries of field %d to: %s\n", FIELD_COUNT - 1,
+                    optarg);
+                break;
         }
     }
 
-    int ok;
-    // Initialize the MPI environment
-    ok = MPI_Init(&argc, &argv);
-    if (ok != MPI_SUCCESS)
+    if (relaxSetExtents(solver, ROWS, COLUMNS, PLANES) != RELAX_OK)
     {
-        printf("Error initialising MPI.\n");
-        MPI_Abort(MPI_COMM_WORLD, ok);
+        return -1;
     }
-
-    // Get the number of processes
-    int world_size;
-    ok = MPI_Comm_size(MPI_COMM_WORLD, &world_size);
-    if (ok != MPI_SUCCESS)
+    relaxSetPrecision(solver, PRECISION);
+    if (relaxSetFields(solver, FIELDS, FIELD_COUNT) != RELAX_OK)
     {
-        printf("Error getting world size.\n");
-        MPI_Abort(MPI_COMM_WORLD, ok);
+        return -1;
     }
 
-    // Get the rank of the process
-    int world_rank;
-    ok = MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    int ok;
+    // Initialize the MPI environment
+    ok = MPI_Init(&argc, &argv);
     if (ok != MPI_SUCCESS)
     {
-        printf("Error getting world rank.\n");
+        printf("Error initialising MPI.\n");
         MPI_Abort(MPI_COMM_WORLD, ok);
     }
 
+    int world_rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
 
-    // Assign a default number of rows that each processor will process. For
-    // example, if 10 processors and a 10x10 array, each processor will be
-    // assigned 1 row.
-    int numRowsPerProc = ARRAY_DIMENSION / world_size;
-
-    // Allocate memory so ready to calculate and store the number of elements
-    // each processor will accept and process. This was used for scatterv. Now
-    // it is used to gather at the end, as well as allocate buffer sizes for the
-    // rows per processor, as well as figure out what data to send/receive
-    // to/from above/below processors via the MPI messaging system.
-    int* sendCounts = (int*) malloc(sizeof(int) * world_size);
-    int* recvCounts = (int*) malloc(sizeof(int) * world_size);
-    int* sendDisplacements = (int*) malloc(sizeof(int) * world_size);
-    int* recvDisplacements = (int*) malloc(sizeof(int) * world_size);
-
-    // Loop to calculate the sendCounts and sendDisplacements arrays. All except
-    // first/last elem will receive the same number of elements. The last
-    // processor will receive the remaining rows. For example, 10 processors and
-    // an 11x11 array, the last proc will relax for 2 rows (but will need to
-    // also receive the row prior so can calculate average).
-    for (int i = 0; i < world_size; i++)
+    if (relaxSolveDistributed(solver, MPI_COMM_WORLD) == RELAX_ERROR)
     {
-        // Send over the data the process will relax, as well as the rows below
-        // and above.
-        sendCounts[i] = (numRowsPerProc * ARRAY_DIMENSION) + (ARRAY_DIMENSION *
-            2);
-        recvCounts[i] = sendCounts[i] - (ARRAY_DIMENSION * 2);
-
-        sendDisplacements[i] = (numRowsPerProc * ARRAY_DIMENSION * i) -
-            ARRAY_DIMENSION;
-        recvDisplacements[i] = (numRowsPerProc * ARRAY_DIMENSION * i);
-        // For the last processor, only need to send one extra row; the row
-        // prior.
-        if (i == (world_size - 1))
-        {
-            numRowsPerProc = (ARRAY_DIMENSION % (world_size)) + numRowsPerProc;
-            sendCounts[i] = (numRowsPerProc * ARRAY_DIMENSION) +
-                ARRAY_DIMENSION;
-            recvCounts[i] = sendCounts[i] - (ARRAY_DIMENSION);
-        }
-        // For the first processor, only need to send one extra row; the row
-        // after.
-        else if (i == 0)
-        {
-            sendCounts[i] = (numRowsPerProc * ARRAY_DIMENSION) +
-                (ARRAY_DIMENSION);
-            recvCounts[i] = sendCounts[i] - (ARRAY_DIMENSION);
-            recvDisplacements[i] = ARRAY_DIMENSION;
-            sendDisplacements[i] = i;
-        }
+        printf("Error solving: there must be an interior row per processor, "
+            "and a method and stencil that support volumes (and fields).\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
     }
 
-    // Re-calculate the numRowsPerProc to what it should be, depending on the
-    // rank of the processor. It was modified in the loop above so must be
-    // redone.
-    numRowsPerProc = ARRAY_DIMENSION / world_size;
-    if (world_rank == (world_size - 1))
+    int cpu, firstRow, lastRow;
+    if (relaxGetWorkerPlacement(solver, 0, &cpu, &firstRow, &lastRow) ==
+        RELAX_OK && cpu >= 0)
     {
-        numRowsPerProc = (ARRAY_DIMENSION % (world_size)) + numRowsPerProc;
+        printf("Rank %d pinned to CPU %d, relaxing %s %d to %d\n",
+            world_rank, cpu, PLANES > 1 ? "planes" : "rows", firstRow,
+            lastRow);
     }
-    else if (world_rank == 0)
-    {
-        numRowsPerProc--;
-    }
-
-    // Create the double matrix per processor. OK to replicate per processor as
-    // not modified, only read from, until computation is finished and root
-    // processor collates the results. Replication avoids communication overhead
-    // of distributing it to each processor. As discussed in the report, this
-    // could be optimised to reduce memory usage.
-    doubleMatrix = createDoubleMatrix(ARRAY_DIMENSION);
 
-    // Double matrix buffer is for storing input data received by each proc.
-    double *doubleMatrixBuffer = (double*) malloc(sizeof(double) *
-        sendCounts[world_rank]);
-    double *doubleMatrixBufferCopy = (double*) malloc(sizeof(double) *
-        sendCounts[world_rank]);
-
-    // Initialise buffer with correct values.
-    for(int i = 0; i < sendCounts[world_rank]; i++)
+    // Report the largest rank, which is what a job has to be sized for.
+    unsigned long long peak = relaxGetFootprint(solver);
+    unsigned long long maxPeak = 0;
+    ok = MPI_Reduce(&peak, &maxPeak, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, 0,
+        MPI_COMM_WORLD);
+    if (ok != MPI_SUCCESS)
     {
-        doubleMatrixBuffer[i] = doubleMatrix[sendDisplacements[world_rank] + i];
+        printf("Error reducing arena footprint.\n");
+        MPI_Abort(MPI_COMM_WORLD, ok);
     }
 
-    while(true)
+    if(world_rank == 0)
     {
-        // Distribute sections of double matrix to all processors.
-        // Send prior rows.
-        if (world_rank > 0)
+        printf("Peak arena footprint per rank: %llu bytes (%s)\n", maxPeak,
+            relaxGetMemoryBacking(solver));
+        // At loose precisions plain Jacobi can need fewer sweeps; there is
+        // no saving to report then.
+        int sweeps = relaxGetIterations(solver);
+        int jacobiSweeps = relaxGetJacobiEstimate(solver);
+        if (jacobiSweeps > sweeps)
         {
-            ok = MPI_Send(doubleMatrixBuffer + ARRAY_DIMENSION, ARRAY_DIMENSION,
-                MPI_DOUBLE, world_rank - 1, 0, MPI_COMM_WORLD);
-            if (ok != MPI_SUCCESS)
-            {
-                printf("Error sending start rows to below processors.\n");
-                MPI_Abort(MPI_COMM_WORLD, ok);
-            }
+            printf("Sweeps: %d (plain Jacobi: %d, %.1f times as many)\n",
+                sweeps, jacobiSweeps, (double) jacobiSweeps / sweeps);
         }
-
-        // Receive ending rows
-        if (world_rank < world_size - 1)
+        else if (jacobiSweeps > 0)
         {
-            MPI_Status stat;
-            ok = MPI_Recv(doubleMatrixBuffer + ((numRowsPerProc + 1) *
-                ARRAY_DIMENSION), ARRAY_DIMENSION, MPI_DOUBLE, world_rank + 1,
-                0, MPI_COMM_WORLD, &stat);
-            if (ok != MPI_SUCCESS)
-            {
-                printf("Error receiving start rows from above processors.\n");
-                MPI_Abort(MPI_COMM_WORLD, ok);
-            }
+            printf("Sweeps: %d (plain Jacobi: %d)\n", sweeps, jacobiSweeps);
         }
-
-        // Minus 1 as proc count starts at 0.
-        // Send ending rows
-        if (world_rank < world_size - 1)
+        if (FIELD_COUNT > 0)
         {
-            ok = MPI_Send(doubleMatrixBuffer + (numRowsPerProc *
-            ARRAY_DIMENSION), ARRAY_DIMENSION, MPI_DOUBLE, world_rank + 1, 1,
-            MPI_COMM_WORLD);
-            if (ok != MPI_SUCCESS)
+            for (int f = 0; f < FIELD_COUNT; f++)
             {
-                printf("Error sending end rows to above processors.\n");
-                MPI_Abort(MPI_COMM_WORLD, ok);
+                printf("Result of field %d (%d sweeps):\n", f,
+                    relaxGetFieldIterations(solver, f));
+                printDoubleMatrix(relaxGetFieldResult(solver, f), ROWS,
+                    COLUMNS, PLANES);
             }
         }
-
-        // Receive prior rows
-        if (world_rank > 0)
+        else
         {
-            MPI_Status stat;
-            ok = MPI_Recv(doubleMatrixBuffer, ARRAY_DIMENSION, MPI_DOUBLE,
-                world_rank - 1, 1, MPI_COMM_WORLD, &stat);
-            if (ok != MPI_SUCCESS)
-            {
-                printf("Error receiving end rows from below processors.\n");
-                MPI_Abort(MPI_COMM_WORLD, ok);
-            }
+            printf("Result:\n");
+            printDoubleMatrix(relaxGetResult(solver, NULL), ROWS, COLUMNS,
+                PLANES);
         }
-
-        // Copy to double matrix buffer copy. This is so we can relax the matrix
-        // using averages calculated from double matrix buffer copy, and store
-        // the relaxed iteration in double matrix buffer.
-        memcpy(doubleMatrixBufferCopy, doubleMatrixBuffer, sizeof(double) *
-            sendCounts[world_rank]);
-
-        // Initialise flag to true. Set to false if difference between current
-        // and new average is outside precision.
-        int balanced = true;
-
-        // Each proc loops through their buffer, starting with rows that they
-        // are responsible for averaging. Remember, numRowsPerProc corresponds
-        // to the raw number of rows they are working on, not including the
-        // additional extra prior/ending rows needed.
-        for(int i = 1; i < numRowsPerProc + 1; i++)
-        {
-            // If the last row (corresponding to the full matrix), then skip the
-            // iteration of the loop. We do not edit the outer elements of the
-            // array. This is required.
-            if (world_rank == (world_size - 1) && i == (numRowsPerProc))
-                continue;
-
-            // Iterate between 1 and second from last element of each row. As
-            // before, we do not edit the outer elements of the array.
-            for(int ii = 1; ii < ARRAY_DIMENSION - 1; ii++)
-            {
-                double average = averageNeighbours(doubleMatrixBufferCopy, ii,
-                    i);
-
-                if (balanced && (fabs(average - getElemFromDoubleMatrix(
-                    doubleMatrixBufferCopy, ARRAY_DIMENSION, ii, i))) >
-                    PRECISION)
-                {
-                    balanced = false;
-                }
-                // Buffer to maintain integrity of double matrix buffer when
-                // averaging (rather than editing double matrix buffer copy).
-                doubleMatrixBuffer[(i * ARRAY_DIMENSION) + ii] = average;
-            }
-        }
-
-        // Check the balance at the root processor. World size should not be too
-        // big so probably fine and cheaper to create this on stack rather than
-        // heap.
-        int balancedArray[world_size];
-        ok = MPI_Gather(&balanced, 1, MPI_INT, &balancedArray, 1,
-            MPI_INT, 0, MPI_COMM_WORLD);
-        if (ok != MPI_SUCCESS)
-        {
-            printf("Error gathering precision reached flags.\n");
-            MPI_Abort(MPI_COMM_WORLD, ok);
-        }
-
-        int done = true;
-
-        if (world_rank == 0)
-        {
-            for (int i = 0; i < world_size; i++)
-            {
-                if (balancedArray[i] != true)
-                {
-                    done = false;
-                    // No need to check further if we know one part not yet
-                    // balanced.
-                    break;
-                }
-            }
-        }
-
-        // Broadcast whether or not precision reached.
-        ok = MPI_Bcast(&done, 1, MPI_INT, 0, MPI_COMM_WORLD);
-        if (ok != MPI_SUCCESS)
-        {
-            printf("Error broadcasting precision reached status.\n");
-            MPI_Abort(MPI_COMM_WORLD, ok);
-        }
-
-        if (done) break;
     }
 
-    // Gather and update root double matrix with relaxed values from each proc.
-    ok = MPI_Gatherv(doubleMatrixBuffer + ARRAY_DIMENSION,
-        recvCounts[world_rank], MPI_DOUBLE, doubleMatrix, recvCounts,
-        recvDisplacements, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-    if (ok != MPI_SUCCESS)
-    {
-        printf("Error gathering solution.\n");
-        MPI_Abort(MPI_COMM_WORLD, ok);
-    }
-
-    if(world_rank == 0)
-    {
-        printf("Result:\n");
-        printDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
-    }
+    relaxDestroy(solver);
 
     // Finalize the MPI environment.
     ok = MPI_Finalize();
@@ -342,16 +292,3 @@ int main(int argc, char** argv)
         MPI_Abort(MPI_COMM_WORLD, ok);
     }
 }
-
-
-
-double averageNeighbours(double* matrix, int x, int y)
-{
-    double avg;
-    avg = getElemFromDoubleMatrix(matrix, ARRAY_DIMENSION, x - 1, y) +
-        getElemFromDoubleMatrix(matrix, ARRAY_DIMENSION, x + 1, y) +
-        getElemFromDoubleMatrix(matrix, ARRAY_DIMENSION, x, y + 1) +
-        getElemFromDoubleMatrix(matrix, ARRAY_DIMENSION, x, y - 1);
-    avg = avg / 4.0;
-    return avg;
-}
@@ -5,50 +5,49 @@
  * @date 03/01/2022
  * @author dancs-dev
  *
- * Compile using:
- * gcc -o sequential.o sequential.c matrix_sequential.c
+ * Compile using (after building librelax, see the README):
+ * gcc -o sequential.o sequential.c -L../common -lrelax -lpthread -lm
  *
- * Run using: ./sequential.o -a ARRAYSIZE -p PRECISION
+ * Run using: ./sequential.o -a ARRAYSIZE -p PRECISION [-t TILESIZE]
+ * [-x ROWS -y COLUMNS -z PLANES] [-k 5|9|weighted:V,H]
  * Example: ./sequential.o -a 4 -p 0.001
  *
  */
 
 
 // Standard header includes
-#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <unistd.h>
-#include <string.h>
-#include <math.h>
 
 
 // Project header includes
-#include "matrix_sequential.h"
+#include "../common/matrix.h"
+#include "../common/relax.h"
 
 
 // Default settings
 double PRECISION    = 0.001;
-int ARRAY_DIMENSION = 4;
+int ROWS            = 4;
+int COLUMNS         = 4;
+int PLANES          = 1;
+int TILE_SIZE       = 0;
 
 
-// Global variables
-double** doubleMatrix;
-double** doubleMatrixCopy;
-
-// Function declarations
-void relaxation();
-double averageNeighbours(double** matrix, int x, int y);
-
 // Function definitions
 int main(int argc, char **argv)
 {
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return -1;
+    }
+
     while(true)
     {
         int c;
-        c = getopt(argc, argv, "a:p:");
+        c = getopt(argc, argv, "a:x:y:z:p:t:k:");
         if (c == -1)
         {
             break;
@@ -56,12 +55,40 @@ int main(int argc, char **argv)
         switch(c)
         {
             case 'a':
-                ARRAY_DIMENSION = atoi(optarg);
-                if (ARRAY_DIMENSION < 3)
+                ROWS = atoi(optarg);
+                COLUMNS = ROWS;
+                if (ROWS < 3)
+                {
+                    return -1;
+                }
+                printf("Set array dimension to: %d\n", ROWS);
+                break;
+
+            case 'x':
+                ROWS = atoi(optarg);
+                if (ROWS < 3)
                 {
                     return -1;
                 }
-                printf("Set array dimension to: %d\n", ARRAY_DIMENSION);
+                printf("Set rows to: %d\n", ROWS);
+                break;
+
+            case 'y':
+                COLUMNS = atoi(optarg);
+                if (COLUMNS < 3)
+                {
+                    return -1;
+                }
+                printf("Set columns to: %d\n", COLUMNS);
+                break;
+
+            case 'z':
+                PLANES = atoi(optarg);
+                if (PLANES < 1 || PLANES == 2)
+                {
+                    return -1;
+                }
+                printf("Set planes to: %d\n", PLANES);
                 break;
 
             case 'p':
@@ -72,64 +99,44 @@ int main(int argc, char **argv)
                 }
                 printf("Set precision to: %f\n", PRECISION);
                 break;
+
+            case 't':
+                TILE_SIZE = atoi(optarg);
+                if (TILE_SIZE < 0)
+                {
+                    return -1;
+                }
+                printf("Set tile size to: %d\n", TILE_SIZE);
+                break;
+
+            case 'k':
+                if (relaxSetStencilByName(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set stencil to: %s\n", optarg);
+                break;
         }
     }
 
-    doubleMatrix = createDoubleMatrix(ARRAY_DIMENSION);
-    doubleMatrixCopy = createDoubleMatrix(ARRAY_DIMENSION);
+    if (relaxSetExtents(solver, ROWS, COLUMNS, PLANES) != RELAX_OK)
+    {
+        return -1;
+    }
+    relaxSetPrecision(solver, PRECISION);
+    relaxSetTiling(solver, TILE_SIZE, 0.1);
+    relaxSetMethod(solver, RELAX_METHOD_JACOBI);
 
-    relaxation();
+    if (relaxSolve(solver) != RELAX_OK)
+    {
+        relaxDestroy(solver);
+        return -1;
+    }
 
     printf("\nResult:\n");
-    printDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
+    printDoubleMatrix(relaxGetResult(solver, NULL), ROWS, COLUMNS, PLANES);
 
-    freeDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
-    freeDoubleMatrix(doubleMatrixCopy, ARRAY_DIMENSION);
+    relaxDestroy(solver);
 
     return 0;
 }
-
-void relaxation()
-{
-    bool balanced = true;
-
-
-    while (true)
-    {
-        for(int i = 0; i < ARRAY_DIMENSION; i++)
-        {
-            memcpy(doubleMatrixCopy[i], doubleMatrix[i], sizeof(double) *
-                ARRAY_DIMENSION);
-        }
-
-        for (int x = 1; x < ARRAY_DIMENSION - 1; x++)
-        {
-            for (int y = 1; y < ARRAY_DIMENSION - 1; y++)
-            {
-                double average = averageNeighbours(doubleMatrixCopy, x, y);
-                if (balanced)
-                {
-                    if (fabs(average - doubleMatrix[x][y]) > PRECISION)
-                    {
-                        balanced = false;
-                    }
-                }
-                doubleMatrix[x][y] = average;
-            }
-        }
-        if (balanced)
-        {
-            break;
-        }
-        balanced = true;
-    }
-}
-
-double averageNeighbours(double** matrix, int x, int y)
-{
-    double avg;
-    avg = matrix[x - 1][y] + matrix[x + 1][y] + matrix[x][y - 1] +
-        matrix[x][y + 1];
-    avg = avg / 4.0;
-    return avg;
-}
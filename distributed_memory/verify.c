@@ -0,0 +1,508 @@
+/**
+ * @file verify.c
+ * @brief Verification and performance harness for the distributed memory
+ * solver.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Compile using (after building librelax with mpicc, see the README):
+ * mpicc -Wall -Wextra -o verify.out verify.c ../common/verify.c -L../common
+ * -lrelax_mpi -lpthread -lm
+ *
+ * Run using: mpirun -np MAXRANKS ./verify.out [-p PRECISION] [-e MAXERROR]
+ * [-l RMSERROR] [-n REPEATS] [-f FILTER] [-b BASELINE [-u] [-s THRESHOLD]]
+ * Example: mpirun -np 4 ./verify.out -b baseline.txt
+ *
+ * Every method solves a matrix of grids (square, rectangular and a volume, with
+ * each 2D stencil) on 1, 2, ... up to all of the ranks started, by splitting
+ * off a communicator of the first few ranks for each case while the rest wait.
+ * Grids with fewer interior rows (planes) than ranks are skipped. Rank 0
+ * compares each result in memory with the sequential Jacobi reference. The
+ * distributed Jacobi sweeps, with or without rebalancing, must match it exactly;
+ * the other methods must match it within the tolerances. The jacobi-fields case
+ * solves each grid under several boundary configurations at once, and each
+ * field must exactly match a sequential Jacobi solve with its boundaries.
+ *
+ * The other flags, the case names and the exit status are as for the shared
+ * memory harness (see shared_memory/verify.c): a result is wrong beyond
+ * MAXERROR (default 1e-6) or RMSERROR (default 2e-7), each case's fastest of
+ * REPEATS solves (default 3) is its time to solution, and with -b a case more
+ * than THRESHOLD (default 0.2) slower than its time in BASELINE is flagged.
+ * Only rank 0 reads or writes BASELINE.
+ *
+ */
+
+#include <mpi.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../common/relax.h"
+#include "../common/relax_mpi.h"
+#include "../common/verify.h"
+
+
+typedef struct
+{
+    int rows;
+    int columns;
+    int planes;
+    const char* stencil;
+} VerifyGrid;
+
+typedef struct
+{
+    const char* name;
+    RelaxMethod method;
+    int rebalance;
+    bool adaptive;
+    bool only2D;
+    // Sweeps the same cells in the same order as the reference, so any
+    // difference at all is wrong.
+    bool exact;
+} VerifyMethod;
+
+
+// The grids: one too small for many ranks, one with a specialised sweep, a
+// rectangle with every 2D stencil, and a volume.
+static const VerifyGrid GRIDS[] =
+{
+    { 5, 5, 1, "5" },
+    { 64, 64, 1, "5" },
+    { 37, 50, 1, "5" },
+    { 37, 50, 1, "9" },
+    { 37, 50, 1, "weighted:1,4" },
+    { 9, 11, 17, "5" }
+};
+
+static const VerifyMethod METHODS[] =
+{
+    { "jacobi", RELAX_METHOD_JACOBI, 0, false, false, true },
+    { "jacobi-r5", RELAX_METHOD_JACOBI, 5, false, false, true },
+    { "chebyshev", RELAX_METHOD_CHEBYSHEV, 0, false, false, false },
+    { "chebyshev-adaptive", RELAX_METHOD_CHEBYSHEV, 0, true, false, false },
+    { "direct", RELAX_METHOD_DIRECT, 0, false, true, false }
+};
+
+// The boundaries of the multi-field case, as in the shared memory harness.
+static const RelaxBoundaries FIELDS[] =
+{
+    { 1.0, 1.0, 0.0, 0.0, 0.0, 0.0 },
+    { 0.0, 0.0, 1.0, 1.0, 0.0, 0.0 },
+    { 2.0, -1.0, 0.5, 0.0, 1.0, 0.0 },
+    { 0.25, 0.25, 0.25, 0.25, 0.25, 0.25 },
+    { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 }
+};
+
+#define FIELD_COUNT ((int) (sizeof(FIELDS) / sizeof(FIELDS[0])))
+
+
+// Default settings
+double PRECISION    = 1e-11;
+char* BASELINE      = NULL;
+bool UPDATE         = false;
+char* FILTER        = NULL;
+
+
+// Function declarations
+static RelaxSolver* createSolver(const VerifyGrid* grid);
+static void runCase(RelaxSolver* solver, MPI_Comm comm,
+    const double* reference, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds);
+static void runFieldsCase(RelaxSolver* solver, MPI_Comm comm,
+    RelaxSolver* const* references, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds);
+
+
+// Function definitions
+int main(int argc, char** argv)
+{
+    int ok = MPI_Init(&argc, &argv);
+    if (ok != MPI_SUCCESS)
+    {
+        printf("MPI_Init() error\n");
+        MPI_Abort(MPI_COMM_WORLD, ok);
+    }
+    int worldRank, worldSize;
+    MPI_Comm_rank(MPI_COMM_WORLD, &worldRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &worldSize);
+
+    VerifyOptions options;
+    options.maxTolerance = 1e-6;
+    options.rmsTolerance = 2e-7;
+    options.threshold = 0.2;
+    options.repeats = 3;
+
+    int c;
+    while ((c = getopt(argc, argv, "p:e:l:n:f:b:us:")) != -1)
+    {
+        switch(c)
+        {
+            case 'p':
+                PRECISION = atof(optarg);
+                if (PRECISION <= 0.0 || PRECISION > 1.0)
+                {
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+
+            case 'e':
+                options.maxTolerance = atof(optarg);
+                break;
+
+            case 'l':
+                options.rmsTolerance = atof(optarg);
+                break;
+
+            case 'n':
+                options.repeats = atoi(optarg);
+                if (options.repeats < 1)
+                {
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+
+            case 'f':
+                FILTER = optarg;
+                break;
+
+            case 'b':
+                BASELINE = optarg;
+                break;
+
+            case 'u':
+                UPDATE = true;
+                break;
+
+            case 's':
+                options.threshold = atof(optarg);
+                if (options.threshold < 0.0)
+                {
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+
+            default:
+                MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+    if (UPDATE && BASELINE == NULL)
+    {
+        if (worldRank == 0)
+        {
+            fprintf(stderr, "-u needs a baseline file (-b)\n");
+        }
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    Baseline baseline = { NULL, 0, 0 };
+    if (worldRank == 0 && BASELINE != NULL &&
+        loadBaseline(&baseline, BASELINE) != 0)
+    {
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    int grids = (int) (sizeof(GRIDS) / sizeof(GRIDS[0]));
+    int methods = (int) (sizeof(METHODS) / sizeof(METHODS[0]));
+    int cases = 0, wrong = 0, slower = 0;
+
+    for (int g = 0; g < grids; g++)
+    {
+        const VerifyGrid* grid = &GRIDS[g];
+        int interior = (grid->planes > 1 ? grid->planes : grid->rows) - 2;
+
+        RelaxSolver* reference = NULL;
+        const double* expected = NULL;
+        if (worldRank == 0)
+        {
+            reference = createSolver(grid);
+            if (reference == NULL || relaxSolve(reference) != RELAX_OK)
+            {
+                fprintf(stderr, "Reference solve failed\n");
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+            expected = relaxGetResult(reference, NULL);
+        }
+
+        for (int m = 0; m < methods; m++)
+        {
+            const VerifyMethod* method = &METHODS[m];
+            if (method->only2D && grid->planes > 1)
+            {
+                continue;
+            }
+
+            for (int ranks = 1; ranks <= worldSize && ranks <= interior;
+                ranks++)
+            {
+                char name[64];
+                snprintf(name, sizeof(name), "%s/%dx%dx%d/%s/np%d",
+                    method->name, grid->rows, grid->columns, grid->planes,
+                    grid->stencil, ranks);
+                if (FILTER != NULL && strstr(name, FILTER) == NULL)
+                {
+                    continue;
+                }
+
+                // World rank 0 is rank 0 of every case, so it holds the
+                // result.
+                MPI_Comm comm;
+                MPI_Comm_split(MPI_COMM_WORLD, worldRank < ranks ? 0 :
+                    MPI_UNDEFINED, worldRank, &comm);
+                if (comm == MPI_COMM_NULL)
+                {
+                    MPI_Barrier(MPI_COMM_WORLD);
+                    continue;
+                }
+
+                RelaxSolver* solver = createSolver(grid);
+                if (solver == NULL)
+                {
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                relaxSetMethod(solver, method->method);
+                relaxSetRebalance(solver, method->rebalance);
+                relaxSetChebyshevAdaptive(solver, method->adaptive);
+
+                VerifyErrors errors;
+                double seconds;
+                runCase(solver, comm, expected, &options, &errors, &seconds);
+                relaxDestroy(solver);
+                MPI_Comm_free(&comm);
+
+                if (worldRank == 0)
+                {
+                    VerifyOptions tolerances = options;
+                    if (method->exact)
+                    {
+                        tolerances.maxTolerance = 0.0;
+                        tolerances.rmsTolerance = 0.0;
+                    }
+                    int outcome = reportCase(name, &errors, seconds,
+                        UPDATE ? NULL : &baseline, &tolerances);
+                    cases++;
+                    wrong += (outcome & VERIFY_WRONG) ? 1 : 0;
+                    slower += (outcome & VERIFY_SLOWER) ? 1 : 0;
+                    if (UPDATE && recordBaseline(&baseline, name, seconds) !=
+                        0)
+                    {
+                        MPI_Abort(MPI_COMM_WORLD, -1);
+                    }
+                }
+                MPI_Barrier(MPI_COMM_WORLD);
+            }
+        }
+        relaxDestroy(reference);
+
+        // Rank 0 solves each field on its own for reference.
+        RelaxSolver* references[FIELD_COUNT];
+        for (int f = 0; f < FIELD_COUNT; f++)
+        {
+            references[f] = NULL;
+            if (worldRank != 0)
+            {
+                continue;
+            }
+            references[f] = createSolver(grid);
+            if (references[f] == NULL ||
+                relaxSetBoundaries(references[f], &FIELDS[f]) != RELAX_OK ||
+                relaxSolve(references[f]) != RELAX_OK)
+            {
+                fprintf(stderr, "Reference solve failed\n");
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+        }
+
+        for (int ranks = 1; ranks <= worldSize && ranks <= interior; ranks++)
+        {
+            char name[64];
+            snprintf(name, sizeof(name), "jacobi-fields/%dx%dx%d/%s/np%d",
+                grid->rows, grid->columns, grid->planes, grid->stencil, ranks);
+            if (FILTER != NULL && strstr(name, FILTER) == NULL)
+            {
+                continue;
+            }
+
+            MPI_Comm comm;
+            MPI_Comm_split(MPI_COMM_WORLD, worldRank < ranks ? 0 :
+                MPI_UNDEFINED, worldRank, &comm);
+            if (comm == MPI_COMM_NULL)
+            {
+                MPI_Barrier(MPI_COMM_WORLD);
+                continue;
+            }
+
+            RelaxSolver* solver = createSolver(grid);
+            if (solver == NULL ||
+                relaxSetFields(solver, FIELDS, FIELD_COUNT) != RELAX_OK)
+            {
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+
+            VerifyErrors errors;
+            double seconds;
+            runFieldsCase(solver, comm, references, &options, &errors,
+                &seconds);
+            relaxDestroy(solver);
+            MPI_Comm_free(&comm);
+
+            if (worldRank == 0)
+            {
+                VerifyOptions exact = options;
+                exact.maxTolerance = 0.0;
+                exact.rmsTolerance = 0.0;
+                int outcome = reportCase(name, &errors, seconds,
+                    UPDATE ? NULL : &baseline, &exact);
+                cases++;
+                wrong += (outcome & VERIFY_WRONG) ? 1 : 0;
+                slower += (outcome & VERIFY_SLOWER) ? 1 : 0;
+                if (UPDATE && recordBaseline(&baseline, name, seconds) != 0)
+                {
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+            }
+            MPI_Barrier(MPI_COMM_WORLD);
+        }
+        for (int f = 0; f < FIELD_COUNT; f++)
+        {
+            relaxDestroy(references[f]);
+        }
+    }
+
+    int status = 0;
+    if (worldRank == 0)
+    {
+        if (UPDATE)
+        {
+            if (saveBaseline(&baseline, BASELINE) != 0)
+            {
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+            printf("Saved baseline to: %s\n", BASELINE);
+        }
+        freeBaseline(&baseline);
+        status = finishVerify(cases, wrong, slower);
+    }
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    MPI_Finalize();
+    return status;
+}
+
+// The reference configuration of a grid: sequential Jacobi.
+static RelaxSolver* createSolver(const VerifyGrid* grid)
+{
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return NULL;
+    }
+    if (relaxSetExtents(solver, grid->rows, grid->columns, grid->planes) !=
+        RELAX_OK || relaxSetStencilByName(solver, grid->stencil) != RELAX_OK)
+    {
+        relaxDestroy(solver);
+        return NULL;
+    }
+    relaxSetPrecision(solver, PRECISION);
+    relaxSetMethod(solver, RELAX_METHOD_JACOBI);
+    return solver;
+}
+
+// Collective over comm. Solves options->repeats times, keeping the largest
+// errors and the fastest time on rank 0. A solve is timed from a barrier to
+// the gathered result on rank 0, which is the last rank to finish.
+static void runCase(RelaxSolver* solver, MPI_Comm comm,
+    const double* reference, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds)
+{
+    int rows, columns, planes;
+    relaxGetExtents(solver, &rows, &columns, &planes);
+    size_t cells = (size_t) rows * (size_t) columns * (size_t) planes;
+
+    errors->maxError = 0.0;
+    errors->rmsError = 0.0;
+    *seconds = 0.0;
+    for (int r = 0; r < options->repeats; r++)
+    {
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        if (relaxSolveDistributed(solver, comm) != RELAX_OK)
+        {
+            fprintf(stderr, "Distributed solve failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        double elapsed = MPI_Wtime() - start;
+        if (r == 0 || elapsed < *seconds)
+        {
+            *seconds = elapsed;
+        }
+
+        const double* result = relaxGetResult(solver, NULL);
+        if (result == NULL)
+        {
+            continue;
+        }
+        VerifyErrors solve;
+        compareGrids(result, reference, cells, &solve);
+        if (!(solve.maxError <= errors->maxError))
+        {
+            errors->maxError = solve.maxError;
+        }
+        if (!(solve.rmsError <= errors->rmsError))
+        {
+            errors->rmsError = solve.rmsError;
+        }
+    }
+}
+
+// As runCase, comparing each field of the result with the reference solve for
+// its boundaries, and keeping the largest errors of any field.
+static void runFieldsCase(RelaxSolver* solver, MPI_Comm comm,
+    RelaxSolver* const* references, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds)
+{
+    int rows, columns, planes;
+    relaxGetExtents(solver, &rows, &columns, &planes);
+    size_t cells = (size_t) rows * (size_t) columns * (size_t) planes;
+
+    errors->maxError = 0.0;
+    errors->rmsError = 0.0;
+    *seconds = 0.0;
+    for (int r = 0; r < options->repeats; r++)
+    {
+        MPI_Barrier(comm);
+        double start = MPI_Wtime();
+        if (relaxSolveDistributed(solver, comm) != RELAX_OK)
+        {
+            fprintf(stderr, "Distributed solve failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        double elapsed = MPI_Wtime() - start;
+        if (r == 0 || elapsed < *seconds)
+        {
+            *seconds = elapsed;
+        }
+
+        for (int f = 0; f < FIELD_COUNT; f++)
+        {
+            const double* result = relaxGetFieldResult(solver, f);
+            if (result == NULL)
+            {
+                continue;
+            }
+            VerifyErrors field;
+            compareGrids(result, relaxGetResult(references[f], NULL), cells,
+                &field);
+            if (!(field.maxError <= errors->maxError))
+            {
+                errors->maxError = field.maxError;
+            }
+            if (!(field.rmsError <= errors->rmsError))
+            {
+                errors->rmsError = field.rmsError;
+            }
+        }
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ * @file batch.c
+ * @brief Source file for batch mode: solving a manifest of small grids on a
+ * persistent worker pool.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * The manifest has one problem per line:
+ *
+ *     ARRAYSIZE PRECISION [TOP LEFT BOTTOM RIGHT]
+ *
+ * Boundaries default to the usual 1.0 top/left and 0.0 bottom/right. Blank
+ * lines and lines starting with '#' are ignored.
+ *
+ * Each grid is solved on one pool thread with the in-place method, so no
+ * threads are created per grid.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "../common/relax.h"
+
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        ((double) (now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static void freeSolvers(RelaxSolver** solvers, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        relaxDestroy(solvers[i]);
+    }
+    free(solvers);
+}
+
+// Reads the manifest into configured solvers. Returns the number of problems,
+// or -1 on error.
+static int readManifest(const char* manifestPath, RelaxSolver*** solversOut)
+{
+    FILE* manifest = fopen(manifestPath, "r");
+    if (manifest == NULL)
+    {
+        perror("fopen() error");
+        return -1;
+    }
+
+    int capacity = 64;
+    int count = 0;
+    RelaxSolver** solvers = (RelaxSolver**) malloc(sizeof(RelaxSolver*) *
+        (unsigned long) capacity);
+    if (solvers == NULL)
+    {
+        fclose(manifest);
+        return -1;
+    }
+
+    char line[256];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), manifest) != NULL)
+    {
+        lineNumber++;
+        char* text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\0')
+        {
+            continue;
+        }
+
+        int dimension;
+        double precision;
+        RelaxBoundaries boundaries = { 1.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
+        int fields = sscanf(text, "%d %lf %lf %lf %lf %lf", &dimension,
+            &precision, &boundaries.top, &boundaries.left, &boundaries.bottom,
+            &boundaries.right);
+        if (fields != 2 && fields != 6)
+        {
+            fprintf(stderr, "%s:%d: expected ARRAYSIZE PRECISION [TOP LEFT "
+                "BOTTOM RIGHT]\n", manifestPath, lineNumber);
+            fclose(manifest);
+            freeSolvers(solvers, count);
+            return -1;
+        }
+
+        if (count == capacity)
+        {
+            capacity *= 2;
+            RelaxSolver** grown = (RelaxSolver**) realloc(solvers,
+                sizeof(RelaxSolver*) * (unsigned long) capacity);
+            if (grown == NULL)
+            {
+                fclose(manifest);
+                freeSolvers(solvers, count);
+                return -1;
+            }
+            solvers = grown;
+        }
+
+        RelaxSolver* solver = relaxCreate();
+        if (solver == NULL ||
+            relaxSetDimension(solver, dimension) != RELAX_OK ||
+            relaxSetPrecision(solver, precision) != RELAX_OK)
+        {
+            fprintf(stderr, "%s:%d: invalid problem\n", manifestPath,
+                lineNumber);
+            relaxDestroy(solver);
+            fclose(manifest);
+            freeSolvers(solvers, count);
+            return -1;
+        }
+        relaxSetBoundaries(solver, &boundaries);
+        relaxSetMethod(solver, RELAX_METHOD_THREADS);
+        relaxSetWorkers(solver, 1);
+        solvers[count++] = solver;
+    }
+    fclose(manifest);
+
+    *solversOut = solvers;
+    return count;
+}
+
+int runBatch(const char* manifestPath, int workers)
+{
+    RelaxSolver** solvers;
+    int count = readManifest(manifestPath, &solvers);
+    if (count < 0)
+    {
+        return -1;
+    }
+
+    RelaxPool* pool = relaxCreatePool(workers);
+    if (pool == NULL)
+    {
+        freeSolvers(solvers, count);
+        return -1;
+    }
+
+    // Only the solves are timed; reading the manifest and starting the pool
+    // are one-off costs.
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = relaxSolveBatch(pool, solvers, count);
+    double elapsed = secondsSince(&start);
+
+    long sweeps = 0;
+    for (int i = 0; i < count; i++)
+    {
+        sweeps += relaxGetIterations(solvers[i]);
+    }
+
+    printf("Solved %d grids on %d workers in %f s (%f solves/s, %ld sweeps)\n",
+        count, workers, elapsed, elapsed > 0.0 ? (double) count / elapsed : 0.0,
+        sweeps);
+
+    relaxDestroyPool(pool);
+    freeSolvers(solvers, count);
+
+    return status == RELAX_OK ? 0 : -1;
+}
@@ -0,0 +1,12 @@
+/**
+ * @file batch.h
+ * @brief Header file for batch mode: solving a manifest of small grids on a
+ * persistent worker pool.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+
+int runBatch(const char* manifestPath, int workers);
@@ -4,67 +4,149 @@
  * @date 28/10/2021
  * @author dancs-dev
  *
- * Compile using:
- * gcc -o shared-memory.o main.c matrix.c -lpthread -Wall -Wextra -Wconversion
+ * Compile using (after building librelax, see the README):
+ * gcc -o shared-memory.o main.c batch.c tune.c server.c -L../common -lrelax
+ * -lpthread -lm
+ * -Wall -Wextra -Wconversion
  *
  * This links the pthread library, as required, and displays maximum warnings.
  *
  * Run using: ./shared-memory.out -a ARRAYSIZE -p PRECISION -w NUMBEROFTHREADS
+ * [-x ROWS -y COLUMNS -z PLANES]
+ * [-m threads|wavefront|jacobi|direct|chebyshev|chebyshev:adaptive]
+ * [-c compact|scatter|CPULIST] [-t TILESIZE] [-k 5|9|weighted:V,H]
+ * [-o FILE [-n SWEEPS]] [-T FILE|unix:PATH] [--no-tune]
+ * [-B TOP,LEFT,BOTTOM,RIGHT[,FRONT,BACK] ...]
+ *
+ * -a sets a square grid; -x and -y set the rows and columns separately. With
+ * -z above 1 the program relaxes a volume of that many planes instead, using
+ * the 7-point stencil (tiling and the -k stencils are 2D only).
+ *
+ * The optional -m flag picks the method. threads (the default) lets the
+ * workers race through the grid, guarded by a mutex per row. wavefront
+ * pipelines the sweeps instead: each worker runs its own sweep a couple of rows
+ * behind the previous worker, without locks, and the result is the same every
+ * run. jacobi is the single threaded reference, and direct solves the grid
+ * exactly with discrete sine transforms split over the workers (2D only), which
+ * makes a quick reference answer for the others.
+ *
+ * chebyshev runs Jacobi sweeps split over the workers, accelerated by
+ * Chebyshev semi-iteration with the spectral radius of the grid (or, with
+ * chebyshev:adaptive, one estimated from the convergence rate), and reports
+ * how many sweeps plain Jacobi would have needed.
+ *
+ * The optional -o flag relaxes a grid too large for memory: the grid is kept in
+ * FILE (created or overwritten, and holding the result afterwards) and
+ * streamed through memory in bands of rows, running SWEEPS sweeps (default 4)
+ * in each pass over the file. This is single threaded, as the disk sets the
+ * pace.
+ *
+ * The optional -T flag streams progress, a line per sweep, to FILE or to the
+ * Unix socket at PATH: the residual, the sweep time, the skew (how many sweeps
+ * separate the fastest and slowest threads) and the estimated time left. A
+ * background thread does the writing, so the solve does not wait for it.
+ *
+ * The optional -B flag, given once per field, solves the grid under several
+ * boundary configurations at once (see relax_fields.c), and prints each
+ * field's result with the sweeps it took to converge. Each field's result is
+ * exactly that of a jacobi solve with its boundaries alone. The fields are
+ * relaxed by jacobi sweeps, which is the method used unless -m picks another
+ * (which is refused), and tuning is skipped.
+ *
+ * The optional -c flag pins each worker thread to a CPU. compact fills one
+ * socket before the next, scatter deals workers round-robin across sockets and
+ * a list such as 0,2,4-7 is used in the order given.
+ *
+ * The optional -t flag splits the grid into tiles of TILESIZE x TILESIZE and
+ * skips tiles that have settled, confirming with a full sweep at the end.
+ *
+ * The optional -k flag picks the stencil: the 5-point average (default), the
+ * compact 9-point Laplacian, or a 5-point average weighting the vertical and
+ * horizontal neighbours V:H.
+ *
+ * Tuning: ./shared-memory.out --autotune [-p PRECISION]
+ * times short solves of every method, worker count and tile size on a few
+ * representative grids and saves the fastest for each to a tuning file for
+ * this host (see tune.c). Later runs load it and use the entry for the nearest
+ * grid size for whichever of -m, -w and -t were not given; --no-tune skips it.
+ *
+ * Batch mode: ./shared-memory.out -b MANIFEST -w NUMBEROFTHREADS
+ * solves every grid listed in MANIFEST (see batch.c) on a pool of worker
+ * threads, one grid per thread at a time, and reports solves per second.
+ *
+ * Server mode: ./shared-memory.out -s SOCKET -w NUMBEROFTHREADS
+ * stays resident and answers solve requests sent over the Unix socket at
+ * SOCKET (see server.c) from a pool of warm worker threads, caching each
+ * result so that repeated requests are answered at once and refined ones
+ * start from the nearest cached solution.
+ *
+ * The solver itself lives in librelax; this program only parses the command
+ * line and prints the result.
  *
  */
 
 
 // Standard header includes
-#include <pthread.h>
+#include <getopt.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <unistd.h>
 
 
 // Project header includes
-#include "matrix.h"
-
-
-// To enable protected reads, uncomment the below line:
-// It will lock more than one column at a time. I believe this is safe, but it
-// has not been thoroughly tested. Intended usage: this should be disabled.
-// #define PROTECTED_READS
-
-// The below flag is used to setup the program for testing with the Python
-// script. It prints out the double matrix after each thread finishes.
-// #define TEST_MODE
+#include "batch.h"
+#include "server.h"
+#include "tune.h"
+#include "../common/matrix.h"
+#include "../common/relax.h"
 
 
 // Default settings
 double PRECISION    = 0.001;
-int ARRAY_DIMENSION = 4;
+int ROWS            = 4;
+int COLUMNS         = 4;
+int PLANES          = 1;
+int TILE_SIZE       = 0;
 int WORKERS         = 1;
-
-
-// Global variables
-double** doubleMatrix;
-pthread_mutex_t* mutexArray;
-
-#ifdef TEST_MODE
-pthread_mutex_t printThread;
-#endif
-
-// Function declarations
-void relaxationWorker(int *tid);
-double averageNeighbours(double** matrix, int x, int y);
-void lockMutexes(pthread_mutex_t* array, int row);
-void unlockMutexes(pthread_mutex_t* array, int row);
+int SWEEPS_PER_PASS = 4;
+char* STORE         = NULL;
+char* MANIFEST      = NULL;
+char* SOCKET_PATH   = NULL;
+bool AUTOTUNE       = false;
+bool USE_TUNING     = true;
+int FIELD_COUNT     = 0;
+RelaxBoundaries FIELDS[RELAX_MAX_FIELDS];
+
+
+// Long options, which have no short form.
+static const struct option LONG_OPTIONS[] =
+{
+    { "autotune", no_argument, NULL, 'A' },
+    { "no-tune", no_argument, NULL, 'N' },
+    { NULL, 0, NULL, 0 }
+};
 
 
 // Function definitions
 int main(int argc, char **argv)
 {
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return -1;
+    }
+
+    // Settings given on the command line win over the tuning file.
+    bool methodGiven = false;
+    bool workersGiven = false;
+    bool tileSizeGiven = false;
+
     while(true)
     {
         int c;
-        c = getopt(argc, argv, "a:p:w:");
+        c = getopt_long(argc, argv, "a:x:y:z:p:w:m:c:b:t:k:o:n:T:B:s:",
+            LONG_OPTIONS, NULL);
         if (c == -1)
         {
             break;
@@ -72,12 +154,40 @@ int main(int argc, char **argv)
         switch(c)
         {
             case 'a':
-                ARRAY_DIMENSION = atoi(optarg);
-                if (ARRAY_DIMENSION < 3)
+                ROWS = atoi(optarg);
+                COLUMNS = ROWS;
+                if (ROWS < 3)
                 {
                     return -1;
                 }
-                printf("Set array dimension to: %d\n", ARRAY_DIMENSION);
+                printf("Set array dimension to: %d\n", ROWS);
+                break;
+
+            case 'x':
+                ROWS = atoi(optarg);
+                if (ROWS < 3)
+                {
+                    return -1;
+                }
+                printf("Set rows to: %d\n", ROWS);
+                break;
+
+            case 'y':
+                COLUMNS = atoi(optarg);
+                if (COLUMNS < 3)
+                {
+                    return -1;
+                }
+                printf("Set columns to: %d\n", COLUMNS);
+                break;
+
+            case 'z':
+                PLANES = atoi(optarg);
+                if (PLANES < 1 || PLANES == 2)
+                {
+                    return -1;
+                }
+                printf("Set planes to: %d\n", PLANES);
                 break;
 
             case 'p':
@@ -89,194 +199,227 @@ int main(int argc, char **argv)
                 printf("Set precision to: %f\n", PRECISION);
                 break;
 
+            case 't':
+                TILE_SIZE = atoi(optarg);
+                if (TILE_SIZE < 0)
+                {
+                    return -1;
+                }
+                tileSizeGiven = true;
+                printf("Set tile size to: %d\n", TILE_SIZE);
+                break;
+
             case 'w':
                 WORKERS = atoi(optarg);
                 if (WORKERS < 1)
                 {
                     return -1;
                 }
+                workersGiven = true;
                 printf("Set number of workers to: %d\n", WORKERS);
                 break;
+
+            case 'm':
+                if (relaxSetMethodByName(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                methodGiven = true;
+                printf("Set method to: %s\n", optarg);
+                break;
+
+            case 'c':
+                if (relaxSetAffinity(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set affinity to: %s\n", relaxGetAffinityName(solver));
+                break;
+
+            case 'k':
+                if (relaxSetStencilByName(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set stencil to: %s\n", optarg);
+                break;
+
+            case 'o':
+                STORE = optarg;
+                printf("Set out-of-core file to: %s\n", STORE);
+                break;
+
+            case 'n':
+                SWEEPS_PER_PASS = atoi(optarg);
+                if (SWEEPS_PER_PASS < 1)
+                {
+                    return -1;
+                }
+                printf("Set sweeps per pass to: %d\n", SWEEPS_PER_PASS);
+                break;
+
+            case 'T':
+                if (relaxSetTelemetry(solver, optarg) != RELAX_OK)
+                {
+                    return -1;
+                }
+                printf("Set telemetry to: %s\n", optarg);
+                break;
+
+            case 'B':
+                if (FIELD_COUNT == RELAX_MAX_FIELDS ||
+                    relaxParseBoundaries(optarg, &FIELDS[FIELD_COUNT]) !=
+                    RELAX_OK)
+                {
+                    return -1;
+                }
+                FIELD_COUNT++;
+                printf("Set boundaries of field %d to: %s\n", FIELD_COUNT - 1,
+                    optarg);
+                break;
+
+            case 'b':
+                MANIFEST = optarg;
+                printf("Set batch manifest to: %s\n", MANIFEST);
+                break;
+
+            case 's':
+                SOCKET_PATH = optarg;
+                printf("Set server socket to: %s\n", SOCKET_PATH);
+                break;
+
+            case 'A':
+                AUTOTUNE = true;
+                break;
+
+            case 'N':
+                USE_TUNING = false;
+                break;
         }
     }
 
-    doubleMatrix = createDoubleMatrix(ARRAY_DIMENSION);
-    mutexArray = createMutexArray(ARRAY_DIMENSION);
-
-    #ifdef TEST_MODE
-    if (pthread_mutex_init(&printThread, NULL) != 0)
+    if (AUTOTUNE)
     {
-        perror("pthread_join() error");
-        exit(-1);
+        relaxDestroy(solver);
+        return runAutotune(PRECISION);
     }
-    #endif
-
-    // Create a pthread type pointer array.
-    pthread_t workers[WORKERS];
 
-    // clock_t start, end;
-    // double cpuTimeUsed;
+    if (MANIFEST != NULL)
+    {
+        relaxDestroy(solver);
+        return runBatch(MANIFEST, WORKERS);
+    }
 
-    // start = clock();
-    // printDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
+    if (SOCKET_PATH != NULL)
+    {
+        relaxDestroy(solver);
+        return runServer(SOCKET_PATH, WORKERS);
+    }
 
-    for (int i = 0; i < WORKERS; i++)
+    if (relaxSetExtents(solver, ROWS, COLUMNS, PLANES) != RELAX_OK)
     {
-        // Call create, takes:
-        // address of pthread,
-        // array of attributes (or NULL for default),
-        // reference to a function,
-        // input to worker thread function (passed in as void pointer).
-        if (pthread_create((void *)&workers[i], NULL,
-            (void*(*)(void*))relaxationWorker, (void *)&i) != 0)
-        {
-            perror("pthread_create() error");
-            return -1;
-        }
+        return -1;
     }
 
-    for (int i = 0; i < WORKERS; i++)
+    if (FIELD_COUNT > 0)
     {
-        if (pthread_join(workers[i], NULL) != 0)
+        if (relaxSetFields(solver, FIELDS, FIELD_COUNT) != RELAX_OK)
         {
-            perror("pthread_join() error");
             return -1;
         }
+        if (!methodGiven)
+        {
+            relaxSetMethod(solver, RELAX_METHOD_JACOBI);
+        }
     }
 
-    // end = clock();
-
-    #ifndef TEST_MODE
-    printf("\nResult:\n");
-    printDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
-    #endif
-    #ifdef PROTECTED_READS
-    printf("Protected reads were enabled.\n");
-    #endif
-
-    // cpuTimeUsed = ((double) (end - start)) / CLOCKS_PER_SEC;
-    // printf("\nCPU time used: %fs\n", cpuTimeUsed);
-
-    freeDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
-    freeMutexArray(mutexArray, ARRAY_DIMENSION);
-
-    return 0;
-}
-
-// This method should guarantee a precision of at least the precision that is
-// set. It may be more precise as the threads finish. I.e., if precision is
-// reached, and there are 20 threads running, all of the threads will finish
-// their computations (through the whole array) before potentially returning. If
-// in the iteration, a calculation was done that was out of a precision, it will
-// do another precision before returning. This may seem wasteful, but the
-// overhead compared to other solutions is actually reasonably small.
-void relaxationWorker(int *tid)
-{
-    bool balanced = true;
-
-    while (true)
+    // The out-of-core method and several fields have nothing to tune.
+    TuningChoice tuning;
+    if (USE_TUNING && STORE == NULL && FIELD_COUNT == 0 &&
+        loadTuning((long) ROWS * COLUMNS * PLANES, &tuning))
     {
-        for (int x = 1; x < ARRAY_DIMENSION - 1; x++)
+        printf("Loaded tuning from: %s\n", tuningFilePath());
+        if (!methodGiven)
         {
-            // Initial design idea involved protecting each value in matrix with
-            // a mutex. That gave a rubbish efficiency. Let's protect each row
-            // instead: we may spend some more time blocked, but at least we can
-            // avoid the tremendous overhead from setting the lock for each
-            // element in the 2D array.
-            lockMutexes(mutexArray, x);
-            for (int y = 1; y < ARRAY_DIMENSION - 1; y++)
-            {
-                double average = averageNeighbours(doubleMatrix, x, y);
-                if (balanced)
-                {
-                    if ((average - doubleMatrix[x][y]) > PRECISION)
-                    {
-                        balanced = false;
-                    }
-                }
-                doubleMatrix[x][y] = average;
-            }
-            unlockMutexes(mutexArray, x);
+            relaxSetMethod(solver, tuning.method);
+            printf("Set method to: %s\n", relaxMethodName(tuning.method));
         }
-        if (balanced)
+        if (!workersGiven)
         {
-            break;
+            WORKERS = tuning.workers;
+            printf("Set number of workers to: %d\n", WORKERS);
+        }
+        // Tiles are 2D only.
+        if (!tileSizeGiven && PLANES == 1)
+        {
+            TILE_SIZE = tuning.tileSize;
+            printf("Set tile size to: %d\n", TILE_SIZE);
         }
-        balanced = true;
     }
-    #ifdef TEST_MODE
-    // We need to use a mutex to protect when print, otherwise we will have
-    // multiple threads printing simultaneously and the output will be rubbish.
-    if (pthread_mutex_lock(&printThread) != 0)
+
+    relaxSetPrecision(solver, PRECISION);
+    relaxSetTiling(solver, TILE_SIZE, 0.1);
+    relaxSetWorkers(solver, WORKERS);
+    if (STORE != NULL)
     {
-        perror("pthread_mutex_lock() error");
-        exit(-1);
+        if (relaxSetOutOfCore(solver, STORE, SWEEPS_PER_PASS) != RELAX_OK)
+        {
+            return -1;
+        }
+        relaxSetMethod(solver, RELAX_METHOD_OUT_OF_CORE);
     }
-    printf("Thread\n");
-    printDoubleMatrix(doubleMatrix, ARRAY_DIMENSION);
-    if (pthread_mutex_unlock(&printThread) != 0)
+
+    if (relaxSolve(solver) != RELAX_OK)
     {
-        perror("pthread_mutex_unlock() error");
-        exit(-1);
+        relaxDestroy(solver);
+        return -1;
     }
-    #endif
-}
 
-double averageNeighbours(double** matrix, int x, int y)
-{
-    double avg;
-    avg = matrix[x - 1][y] + matrix[x + 1][y] + matrix[x][y - 1] +
-        matrix[x][y + 1];
-    avg = avg / 4.0;
-    return avg;
-}
+    printf("Peak arena footprint: %zu bytes (%s)\n", relaxGetFootprint(solver),
+        relaxGetMemoryBacking(solver));
 
-void lockMutexes(pthread_mutex_t* array, int row)
-{
-    #ifdef PROTECTED_READS
-    if (pthread_mutex_lock(&array[row - 1]) != 0)
+    // At loose precisions plain Jacobi can need fewer sweeps; there is no
+    // saving to report then.
+    int sweeps = relaxGetIterations(solver);
+    int jacobiSweeps = relaxGetJacobiEstimate(solver);
+    if (jacobiSweeps > sweeps)
     {
-        perror("pthread_mutex_lock() error");
-        exit(-1);
+        printf("Sweeps: %d (plain Jacobi: %d, %.1f times as many)\n", sweeps,
+            jacobiSweeps, (double) jacobiSweeps / sweeps);
     }
-    #endif
-
-    if (pthread_mutex_lock(&array[row]) != 0)
+    else if (jacobiSweeps > 0)
     {
-        perror("pthread_mutex_lock() error");
-        exit(-1);
+        printf("Sweeps: %d (plain Jacobi: %d)\n", sweeps, jacobiSweeps);
     }
 
-    #ifdef PROTECTED_READS
-    if (pthread_mutex_lock(&array[row + 1]) != 0)
+    for (int i = 0; i < WORKERS; i++)
     {
-        perror("pthread_mutex_lock() error");
-        exit(-1);
+        int cpu, firstRow, lastRow;
+        if (relaxGetWorkerPlacement(solver, i, &cpu, &firstRow, &lastRow) ==
+            RELAX_OK && cpu >= 0)
+        {
+            printf("Worker %d pinned to CPU %d, initialised rows %d to %d\n",
+                i, cpu, firstRow, lastRow);
+        }
     }
-    #endif
-}
 
-void unlockMutexes(pthread_mutex_t* array, int row)
-{
-    // If we use protected reads, ensure we release the locks in reverse order
-    // from which we used them.
-    #ifdef PROTECTED_READS
-    if (pthread_mutex_unlock(&array[row + 1]) != 0)
-    {
-        perror("pthread_mutex_unlock() error");
-        exit(-1);
-    }
-    #endif
-    if (pthread_mutex_unlock(&array[row]) != 0)
+    if (FIELD_COUNT > 0)
     {
-        perror("pthread_mutex_unlock() error");
-        exit(-1);
+        for (int f = 0; f < FIELD_COUNT; f++)
+        {
+            printf("\nResult of field %d (%d sweeps):\n", f,
+                relaxGetFieldIterations(solver, f));
+            printDoubleMatrix(relaxGetFieldResult(solver, f), ROWS, COLUMNS,
+                PLANES);
+        }
     }
-    #ifdef PROTECTED_READS
-    if (pthread_mutex_unlock(&array[row - 1]) != 0)
+    else
     {
-        perror("pthread_mutex_unlock() error");
-        exit(-1);
+        printf("\nResult:\n");
+        printDoubleMatrix(relaxGetResult(solver, NULL), ROWS, COLUMNS, PLANES);
     }
-    #endif
+
+    relaxDestroy(solver);
+
+    return 0;
 }
@@ -0,0 +1,816 @@
+/**
+ * @file server.c
+ * @brief Source file for server mode: a resident solver answering requests
+ * over a Unix socket from a pool of warm threads and a cache of results.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Clients connect to the socket and send one request per line:
+ *
+ *     SOLVE ROWS COLUMNS PLANES PRECISION [TOP,LEFT,BOTTOM,RIGHT[,FRONT,BACK]]
+ *     SHUTDOWN
+ *
+ * Boundaries default to the usual 1.0 top/left and 0.0 elsewhere. A grid may
+ * have at most SERVER_MAX_CELLS cells. Each request gets a binary reply: a
+ * ServerReply header (see server.h), followed for a solve by the grid. A client
+ * may send several requests on one connection, and the replies come back in
+ * the same order.
+ *
+ * The pool threads and one solver per thread are created once, so a solve
+ * costs no process or thread start up, and each solver keeps its arena, and so
+ * its grids, from one request to the next. Requests that arrive together from
+ * different clients are solved together, one per thread, with the in-place
+ * method, as in batch mode.
+ *
+ * Every result is cached under its size, precision and boundaries, up to
+ * SERVER_CACHE_BYTES, dropping the least recently used first. A request for a
+ * grid already solved to the same or a finer precision is answered from the
+ * cache without solving. Any other request starts from the nearest cached
+ * solution of the same size, if there is one (the same boundaries first, then
+ * the closest), so refining a solution to a finer precision only runs the
+ * extra sweeps. A warm-started result meets the requested precision but is not
+ * bit for bit the result of a solve from zero.
+ *
+ * Replies are written by the one thread that serves every client. A client
+ * that has not read the whole of a reply SERVER_SEND_SECONDS after it was
+ * sent is dropped rather than stalling the rest.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "server.h"
+#include "../common/relax.h"
+
+
+#define SERVER_MAX_CLIENTS 64
+
+// Longest request line, including the newline.
+#define SERVER_LINE_LENGTH 256
+
+// Memory the cached grids may use.
+#define SERVER_CACHE_BYTES (256UL << 20)
+
+// Largest grid a request may ask for, so that its result can be cached.
+#define SERVER_MAX_CELLS ((long) (SERVER_CACHE_BYTES / sizeof(double)))
+
+// Longest a client may take to read a reply before it is dropped, so one that
+// reads slowly, or not at all, cannot stall the others.
+#define SERVER_SEND_SECONDS 5
+
+
+typedef struct
+{
+    int rows;
+    int columns;
+    int planes;
+    double precision;
+    RelaxBoundaries boundaries;
+} ServerKey;
+
+typedef struct
+{
+    ServerKey key;
+    double* grid;
+    int iterations;
+    unsigned long lastUsed;
+} CacheEntry;
+
+typedef struct
+{
+    CacheEntry* entries;
+    int count;
+    int capacity;
+    size_t bytes;
+    unsigned long clock;
+} ResultCache;
+
+typedef struct
+{
+    int fd;
+    // Received text not yet handled, which may hold several lines.
+    char text[SERVER_LINE_LENGTH];
+    size_t length;
+    // The client has stopped sending, so it is closed once its last request
+    // is answered.
+    bool hungUp;
+} ServerClient;
+
+typedef struct
+{
+    int client;
+    ServerKey key;
+    int source;
+} PendingSolve;
+
+typedef struct
+{
+    int listener;
+    int workers;
+    RelaxPool* pool;
+    // One solver per pool thread, reused for every request.
+    RelaxSolver** slots;
+    ServerClient clients[SERVER_MAX_CLIENTS];
+    ResultCache cache;
+    bool stopping;
+    long solved;
+    long warmStarted;
+    long cached;
+} Server;
+
+typedef enum
+{
+    REQUEST_INVALID,
+    REQUEST_SOLVE,
+    REQUEST_SHUTDOWN
+} RequestType;
+
+
+static volatile sig_atomic_t INTERRUPTED = 0;
+
+
+static void onSignal(int signal)
+{
+    (void) signal;
+    INTERRUPTED = 1;
+}
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        ((double) (now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static size_t gridBytes(const ServerKey* key)
+{
+    return sizeof(double) * (size_t) key->rows * (size_t) key->columns *
+        (size_t) key->planes;
+}
+
+static bool sameGrid(const ServerKey* a, const ServerKey* b)
+{
+    return a->rows == b->rows && a->columns == b->columns &&
+        a->planes == b->planes;
+}
+
+static bool sameBoundaries(const ServerKey* a, const ServerKey* b)
+{
+    return memcmp(&a->boundaries, &b->boundaries,
+        sizeof(RelaxBoundaries)) == 0;
+}
+
+static double boundaryDistance(const ServerKey* a, const ServerKey* b)
+{
+    const RelaxBoundaries* x = &a->boundaries;
+    const RelaxBoundaries* y = &b->boundaries;
+    return fabs(x->top - y->top) + fabs(x->left - y->left) +
+        fabs(x->bottom - y->bottom) + fabs(x->right - y->right) +
+        fabs(x->front - y->front) + fabs(x->back - y->back);
+}
+
+// Returns the cached solution of the same problem with the finest precision at
+// least as fine as the key's, or NULL.
+static CacheEntry* findCached(ResultCache* cache, const ServerKey* key)
+{
+    CacheEntry* best = NULL;
+    for (int i = 0; i < cache->count; i++)
+    {
+        CacheEntry* entry = &cache->entries[i];
+        if (sameGrid(&entry->key, key) && sameBoundaries(&entry->key, key) &&
+            entry->key.precision <= key->precision &&
+            (best == NULL || entry->key.precision < best->key.precision))
+        {
+            best = entry;
+        }
+    }
+    if (best != NULL)
+    {
+        best->lastUsed = ++cache->clock;
+    }
+    return best;
+}
+
+// Returns the cached solution of the same size with the closest boundaries,
+// and of those the finest precision, or NULL.
+static CacheEntry* findNearest(ResultCache* cache, const ServerKey* key)
+{
+    CacheEntry* best = NULL;
+    double bestDistance = 0.0;
+    for (int i = 0; i < cache->count; i++)
+    {
+        CacheEntry* entry = &cache->entries[i];
+        if (!sameGrid(&entry->key, key))
+        {
+            continue;
+        }
+        double distance = boundaryDistance(&entry->key, key);
+        if (best == NULL || distance < bestDistance ||
+            (distance == bestDistance &&
+            entry->key.precision < best->key.precision))
+        {
+            best = entry;
+            bestDistance = distance;
+        }
+    }
+    if (best != NULL)
+    {
+        best->lastUsed = ++cache->clock;
+    }
+    return best;
+}
+
+static void removeCached(ResultCache* cache, int index)
+{
+    cache->bytes -= gridBytes(&cache->entries[index].key);
+    free(cache->entries[index].grid);
+    cache->entries[index] = cache->entries[--cache->count];
+}
+
+// Keeps a copy of the grid. Solutions of the same problem to a coarser
+// precision are dropped, as this one answers their requests too. A grid
+// larger than the whole cache is not kept.
+static void insertCached(ResultCache* cache, const ServerKey* key,
+    const double* grid, int iterations)
+{
+    size_t bytes = gridBytes(key);
+    if (bytes > SERVER_CACHE_BYTES)
+    {
+        return;
+    }
+
+    for (int i = cache->count - 1; i >= 0; i--)
+    {
+        const ServerKey* other = &cache->entries[i].key;
+        if (sameGrid(other, key) && sameBoundaries(other, key) &&
+            other->precision >= key->precision)
+        {
+            removeCached(cache, i);
+        }
+    }
+    while (cache->bytes + bytes > SERVER_CACHE_BYTES)
+    {
+        int oldest = 0;
+        for (int i = 1; i < cache->count; i++)
+        {
+            if (cache->entries[i].lastUsed < cache->entries[oldest].lastUsed)
+            {
+                oldest = i;
+            }
+        }
+        removeCached(cache, oldest);
+    }
+
+    if (cache->count == cache->capacity)
+    {
+        int capacity = cache->capacity > 0 ? cache->capacity * 2 : 16;
+        CacheEntry* entries = (CacheEntry*) realloc(cache->entries,
+            sizeof(CacheEntry) * (size_t) capacity);
+        if (entries == NULL)
+        {
+            perror("realloc() error");
+            return;
+        }
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    double* copy = (double*) malloc(bytes);
+    if (copy == NULL)
+    {
+        perror("malloc() error");
+        return;
+    }
+    memcpy(copy, grid, bytes);
+
+    CacheEntry* entry = &cache->entries[cache->count++];
+    entry->key = *key;
+    entry->grid = copy;
+    entry->iterations = iterations;
+    entry->lastUsed = ++cache->clock;
+    cache->bytes += bytes;
+}
+
+static RequestType parseRequest(const char* line, ServerKey* key)
+{
+    char command[16];
+    int consumed;
+    if (sscanf(line, "%15s%n", command, &consumed) != 1)
+    {
+        return REQUEST_INVALID;
+    }
+    if (strcmp(command, "SHUTDOWN") == 0)
+    {
+        return REQUEST_SHUTDOWN;
+    }
+    if (strcmp(command, "SOLVE") != 0)
+    {
+        return REQUEST_INVALID;
+    }
+
+    char boundaries[128];
+    char extra;
+    int fields = sscanf(line + consumed, "%d %d %d %lf %127s %c", &key->rows,
+        &key->columns, &key->planes, &key->precision, boundaries, &extra);
+    if (fields != 4 && fields != 5)
+    {
+        return REQUEST_INVALID;
+    }
+    if (key->rows < 3 || key->columns < 3 || key->planes < 1 ||
+        key->planes == 2 || !(key->precision > 0.0 && key->precision <= 1.0))
+    {
+        return REQUEST_INVALID;
+    }
+    // The solvers index the stack of planes with an int, and every grid is
+    // held in memory; refuse what would overflow the one or exhaust the other.
+    long stackRows = (long) key->rows * key->planes;
+    if (stackRows > INT_MAX || stackRows * key->columns > SERVER_MAX_CELLS)
+    {
+        return REQUEST_INVALID;
+    }
+
+    RelaxBoundaries defaults = { 1.0, 1.0, 0.0, 0.0, 0.0, 0.0 };
+    key->boundaries = defaults;
+    if (fields == 5 &&
+        relaxParseBoundaries(boundaries, &key->boundaries) != RELAX_OK)
+    {
+        return REQUEST_INVALID;
+    }
+    return REQUEST_SOLVE;
+}
+
+// Writes all of the buffer, waiting for the client to make room until
+// SERVER_SEND_SECONDS after start. Returns -1 if the client has gone, or has
+// not read it all by then.
+static int sendAll(int fd, const void* buffer, size_t length,
+    const struct timespec* start)
+{
+    const char* next = (const char*) buffer;
+    while (length > 0)
+    {
+        ssize_t written = send(fd, next, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (written >= 0)
+        {
+            next += written;
+            length -= (size_t) written;
+            continue;
+        }
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            return -1;
+        }
+
+        int wait = (int) ((SERVER_SEND_SECONDS - secondsSince(start)) *
+            1000.0);
+        if (wait <= 0)
+        {
+            fprintf(stderr, "Client too slow reading its reply, dropping "
+                "it.\n");
+            return -1;
+        }
+        struct pollfd writable;
+        writable.fd = fd;
+        writable.events = POLLOUT;
+        if (poll(&writable, 1, wait) < 0 && errno != EINTR)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void closeClient(ServerClient* client)
+{
+    close(client->fd);
+    client->fd = -1;
+    client->length = 0;
+    client->hungUp = false;
+}
+
+// Sends a reply, with the grid of key unless grid is NULL. A client that has
+// gone is closed.
+static void sendReply(ServerClient* client, int status, const ServerKey* key,
+    const double* grid, int source, int iterations, double seconds)
+{
+    ServerReply reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.status = status;
+    reply.source = source;
+    reply.iterations = iterations;
+    reply.seconds = seconds;
+    if (grid != NULL)
+    {
+        reply.rows = key->rows;
+        reply.columns = key->columns;
+        reply.planes = key->planes;
+    }
+    // One deadline covers the whole reply.
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (sendAll(client->fd, &reply, sizeof(reply), &start) != 0 ||
+        (grid != NULL &&
+        sendAll(client->fd, grid, gridBytes(key), &start) != 0))
+    {
+        closeClient(client);
+    }
+}
+
+// Removes the first line from the client's text.
+static void consumeLine(ServerClient* client)
+{
+    char* end = (char*) memchr(client->text, '\0', client->length);
+    size_t used = (size_t) (end - client->text) + 1;
+    memmove(client->text, client->text + used, client->length - used);
+    client->length -= used;
+}
+
+// Solves the pending requests together, one per pool thread, and answers
+// them.
+static void solvePending(Server* server, PendingSolve* pending, int count)
+{
+    RelaxSolver* batch[count];
+    int solving = 0;
+    for (int i = 0; i < count; i++)
+    {
+        RelaxSolver* solver = server->slots[i];
+        const ServerKey* key = &pending[i].key;
+        if (relaxSetExtents(solver, key->rows, key->columns, key->planes) !=
+            RELAX_OK)
+        {
+            sendReply(&server->clients[pending[i].client], -1, NULL, NULL,
+                SERVER_SOLVED, 0, 0.0);
+            pending[i].client = -1;
+            continue;
+        }
+        relaxSetPrecision(solver, key->precision);
+        relaxSetBoundaries(solver, &key->boundaries);
+
+        CacheEntry* nearest = findNearest(&server->cache, key);
+        relaxSetInitialGuess(solver, nearest != NULL ? nearest->grid : NULL);
+        pending[i].source = nearest != NULL ? SERVER_WARM_STARTED :
+            SERVER_SOLVED;
+        batch[solving++] = solver;
+    }
+    if (solving == 0)
+    {
+        return;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    relaxSolveBatch(server->pool, batch, solving);
+    double elapsed = secondsSince(&start);
+
+    for (int i = 0; i < count; i++)
+    {
+        RelaxSolver* solver = server->slots[i];
+        relaxSetInitialGuess(solver, NULL);
+        if (pending[i].client < 0)
+        {
+            continue;
+        }
+
+        ServerClient* client = &server->clients[pending[i].client];
+        const ServerKey* key = &pending[i].key;
+        // Each request stands or falls on its own solve.
+        const double* grid = relaxGetStatus(solver) == RELAX_OK ?
+            relaxGetResult(solver, NULL) : NULL;
+        int iterations = relaxGetIterations(solver);
+        if (grid != NULL)
+        {
+            insertCached(&server->cache, key, grid, iterations);
+            if (pending[i].source == SERVER_WARM_STARTED)
+            {
+                server->warmStarted++;
+            }
+            else
+            {
+                server->solved++;
+            }
+        }
+        sendReply(client, grid != NULL ? 0 : -1, key, grid, pending[i].source,
+            iterations, elapsed);
+    }
+}
+
+// Handles the next request of every client that has one, solving together
+// those the cache cannot answer. Requests for the same problem are left for
+// the next round, when the first will have been cached. Returns the number of
+// requests handled.
+static int serveRound(Server* server)
+{
+    PendingSolve pending[server->workers];
+    int count = 0;
+    int handled = 0;
+
+    for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+    {
+        ServerClient* client = &server->clients[c];
+        char* end = client->fd >= 0 ?
+            (char*) memchr(client->text, '\n', client->length) : NULL;
+        if (end == NULL)
+        {
+            continue;
+        }
+        *end = '\0';
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ServerKey key;
+        RequestType type = parseRequest(client->text, &key);
+        if (type == REQUEST_SOLVE)
+        {
+            bool deferred = (count == server->workers);
+            for (int i = 0; i < count && !deferred; i++)
+            {
+                deferred = sameGrid(&pending[i].key, &key) &&
+                    sameBoundaries(&pending[i].key, &key);
+            }
+            CacheEntry* entry = findCached(&server->cache, &key);
+            if (entry == NULL && deferred)
+            {
+                *end = '\n';
+                continue;
+            }
+
+            consumeLine(client);
+            if (entry != NULL)
+            {
+                server->cached++;
+                sendReply(client, 0, &key, entry->grid, SERVER_CACHED,
+                    entry->iterations, secondsSince(&start));
+            }
+            else
+            {
+                pending[count].client = c;
+                pending[count].key = key;
+                count++;
+            }
+        }
+        else
+        {
+            consumeLine(client);
+            if (type == REQUEST_SHUTDOWN)
+            {
+                server->stopping = true;
+                sendReply(client, 0, NULL, NULL, SERVER_SOLVED, 0, 0.0);
+            }
+            else
+            {
+                sendReply(client, -1, NULL, NULL, SERVER_SOLVED, 0, 0.0);
+            }
+        }
+        handled++;
+    }
+
+    if (count > 0)
+    {
+        solvePending(server, pending, count);
+    }
+    return handled;
+}
+
+static void acceptClient(Server* server)
+{
+    int fd = accept(server->listener, NULL, NULL);
+    if (fd < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN)
+        {
+            perror("accept() error");
+        }
+        return;
+    }
+    for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+    {
+        if (server->clients[c].fd < 0)
+        {
+            server->clients[c].fd = fd;
+            return;
+        }
+    }
+    fprintf(stderr, "Too many clients, refusing a connection.\n");
+    close(fd);
+}
+
+// Appends what the client has sent. A line too long to hold is refused.
+static void readClient(ServerClient* client)
+{
+    size_t space = sizeof(client->text) - client->length;
+    if (space == 0)
+    {
+        sendReply(client, -1, NULL, NULL, SERVER_SOLVED, 0, 0.0);
+        if (client->fd >= 0)
+        {
+            closeClient(client);
+        }
+        return;
+    }
+
+    ssize_t received = recv(client->fd, client->text + client->length, space,
+        0);
+    if (received < 0)
+    {
+        if (errno != EINTR)
+        {
+            closeClient(client);
+        }
+        return;
+    }
+    if (received == 0)
+    {
+        client->hungUp = true;
+        return;
+    }
+    client->length += (size_t) received;
+}
+
+static int openListener(const char* socketPath)
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Socket path too long: %s\n", socketPath);
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    // Replace the socket of a server that did not shut down cleanly, but
+    // nothing else.
+    struct stat existing;
+    if (lstat(socketPath, &existing) == 0)
+    {
+        if (!S_ISSOCK(existing.st_mode))
+        {
+            fprintf(stderr, "Not a socket: %s\n", socketPath);
+            return -1;
+        }
+        unlink(socketPath);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        perror("socket() error");
+        return -1;
+    }
+    if (bind(fd, (struct sockaddr*) &address, sizeof(address)) != 0 ||
+        listen(fd, SERVER_MAX_CLIENTS) != 0)
+    {
+        perror("bind() error");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int runServer(const char* socketPath, int workers)
+{
+    Server server;
+    memset(&server, 0, sizeof(server));
+    server.workers = workers;
+    for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+    {
+        server.clients[c].fd = -1;
+    }
+
+    server.slots = (RelaxSolver**) calloc((size_t) workers,
+        sizeof(RelaxSolver*));
+    if (server.slots == NULL)
+    {
+        return -1;
+    }
+    int status = 0;
+    for (int i = 0; i < workers && status == 0; i++)
+    {
+        server.slots[i] = relaxCreate();
+        if (server.slots[i] == NULL)
+        {
+            status = -1;
+            break;
+        }
+        relaxSetMethod(server.slots[i], RELAX_METHOD_THREADS);
+        relaxSetWorkers(server.slots[i], 1);
+    }
+    server.pool = status == 0 ? relaxCreatePool(workers) : NULL;
+    server.listener = server.pool != NULL ? openListener(socketPath) : -1;
+    if (server.listener < 0)
+    {
+        status = -1;
+    }
+
+    if (status == 0)
+    {
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        printf("Serving on %s with %d workers\n", socketPath, workers);
+        fflush(stdout);
+    }
+
+    while (status == 0 && !server.stopping && !INTERRUPTED)
+    {
+        struct pollfd fds[SERVER_MAX_CLIENTS + 1];
+        int indices[SERVER_MAX_CLIENTS + 1];
+        int watched = 0;
+        fds[watched].fd = server.listener;
+        fds[watched].events = POLLIN;
+        indices[watched++] = -1;
+        for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+        {
+            if (server.clients[c].fd >= 0 && !server.clients[c].hungUp)
+            {
+                fds[watched].fd = server.clients[c].fd;
+                fds[watched].events = POLLIN;
+                indices[watched++] = c;
+            }
+        }
+
+        if (poll(fds, (nfds_t) watched, -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                perror("poll() error");
+                status = -1;
+            }
+            continue;
+        }
+        for (int i = 1; i < watched; i++)
+        {
+            if (fds[i].revents != 0)
+            {
+                readClient(&server.clients[indices[i]]);
+            }
+        }
+        if (fds[0].revents & POLLIN)
+        {
+            acceptClient(&server);
+        }
+
+        while (!server.stopping && serveRound(&server) > 0)
+        {
+        }
+
+        // A client that has hung up is closed once it has been answered.
+        for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+        {
+            ServerClient* client = &server.clients[c];
+            if (client->fd >= 0 && client->hungUp &&
+                memchr(client->text, '\n', client->length) == NULL)
+            {
+                closeClient(client);
+            }
+        }
+    }
+
+    if (server.listener >= 0)
+    {
+        close(server.listener);
+        unlink(socketPath);
+        printf("Answered %ld requests: %ld solved, %ld warm started, %ld from "
+            "the cache\n", server.solved + server.warmStarted + server.cached,
+            server.solved, server.warmStarted, server.cached);
+    }
+    for (int c = 0; c < SERVER_MAX_CLIENTS; c++)
+    {
+        if (server.clients[c].fd >= 0)
+        {
+            close(server.clients[c].fd);
+        }
+    }
+    for (int i = 0; i < server.cache.count; i++)
+    {
+        free(server.cache.entries[i].grid);
+    }
+    free(server.cache.entries);
+    relaxDestroyPool(server.pool);
+    for (int i = 0; i < workers; i++)
+    {
+        relaxDestroy(server.slots[i]);
+    }
+    free(server.slots);
+
+    return status;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file server.h
+ * @brief Header file for server mode: a resident solver answering requests
+ * over a Unix socket from a pool of warm threads and a cache of results.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+
+// Where the grid of a reply came from.
+#define SERVER_SOLVED 0
+#define SERVER_CACHED 1
+#define SERVER_WARM_STARTED 2
+
+// Header of every reply, in the byte order of the host. A successful reply is
+// followed by rows * columns * planes doubles, in the layout relaxGetResult
+// uses; a failed one (status -1) by nothing.
+typedef struct
+{
+    int32_t status;
+    // SERVER_SOLVED, SERVER_CACHED or SERVER_WARM_STARTED.
+    int32_t source;
+    int32_t rows;
+    int32_t columns;
+    int32_t planes;
+    // Sweeps of the solve that produced the grid.
+    int32_t iterations;
+    // Seconds the server spent on the request.
+    double seconds;
+} ServerReply;
+
+
+// Listens on the Unix socket at socketPath (replacing any stale socket there)
+// and answers requests until a client sends SHUTDOWN or the process is
+// interrupted. Solves run on a pool of the given number of threads.
+int runServer(const char* socketPath, int workers);
@@ -0,0 +1,264 @@
+/**
+ * @file tune.c
+ * @brief Source file for the autotuner: timed probes that pick the method,
+ * worker count and tile size for this host, saved to a per-host tuning file.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Each probe solves a representative grid with one configuration: the threaded
+ * method with and without tiles, or the wavefront method, on 1, 2, 4, ... up to
+ * every online CPU. Solves are repeated until a probe has run long enough to
+ * time, and a probe is abandoned through the progress callback as soon as it
+ * is slower than the best so far, so slow configurations cost little.
+ *
+ * The tuning file has one line per size:
+ *
+ *     CELLS METHOD WORKERS TILESIZE
+ *
+ * Lines starting with '#' are ignored, so the file can be edited by hand.
+ */
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tune.h"
+
+
+// Representative grid dimensions: one that fits in cache, one that fits in the
+// last level cache of most hosts, and one that does not.
+static const int TUNING_DIMENSIONS[] = { 32, 128, 512 };
+
+static const int TUNING_TILE_SIZES[] = { 0, 16, 32, 64 };
+
+// The methods probed, and so the only ones a tuning file may name.
+static const RelaxMethod TUNING_METHODS[] =
+    { RELAX_METHOD_THREADS, RELAX_METHOD_WAVEFRONT };
+
+// A probe repeats its solve until it has run for at least this long.
+#define TUNING_MIN_SECONDS 0.05
+
+// No single solve of a probe may take longer than this.
+#define TUNING_MAX_SECONDS 5.0
+
+
+typedef struct
+{
+    struct timespec start;
+    double limit;
+} ProbeDeadline;
+
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        ((double) (now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static int checkDeadline(const RelaxProgress* progress, void* userData)
+{
+    (void) progress;
+    ProbeDeadline* deadline = (ProbeDeadline*) userData;
+    return secondsSince(&deadline->start) > deadline->limit;
+}
+
+// Returns the mean seconds per solve, or a negative value if a solve was slower
+// than limit.
+static double runProbe(RelaxSolver* solver, double limit)
+{
+    ProbeDeadline deadline;
+    deadline.limit = limit;
+    relaxSetProgressCallback(solver, checkDeadline, &deadline);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int solves = 0;
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline.start);
+        if (relaxSolve(solver) != RELAX_OK)
+        {
+            return -1.0;
+        }
+        solves++;
+    }
+    while (secondsSince(&start) < TUNING_MIN_SECONDS);
+
+    return secondsSince(&start) / solves;
+}
+
+const char* tuningFilePath(void)
+{
+    static char path[PATH_MAX];
+    const char* override = getenv("RELAX_TUNING_FILE");
+    if (override != NULL)
+    {
+        return override;
+    }
+
+    char host[256];
+    if (gethostname(host, sizeof(host)) != 0)
+    {
+        strcpy(host, "localhost");
+    }
+    host[sizeof(host) - 1] = '\0';
+    const char* home = getenv("HOME");
+    snprintf(path, sizeof(path), "%s/.relax-tuning-%s",
+        home != NULL ? home : ".", host);
+    return path;
+}
+
+int runAutotune(double precision)
+{
+    int cpus = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+    {
+        cpus = 1;
+    }
+
+    int methods = (int) (sizeof(TUNING_METHODS) / sizeof(TUNING_METHODS[0]));
+    int sizes = (int) (sizeof(TUNING_DIMENSIONS) /
+        sizeof(TUNING_DIMENSIONS[0]));
+    int tileSizes = (int) (sizeof(TUNING_TILE_SIZES) /
+        sizeof(TUNING_TILE_SIZES[0]));
+    TuningChoice best[sizes];
+
+    for (int s = 0; s < sizes; s++)
+    {
+        int dimension = TUNING_DIMENSIONS[s];
+        double bestSeconds = TUNING_MAX_SECONDS;
+        // The defaults, in case every probe runs out of time.
+        best[s].method = RELAX_METHOD_THREADS;
+        best[s].workers = 1;
+        best[s].tileSize = 0;
+
+        for (int m = 0; m < methods; m++)
+        {
+            RelaxMethod method = TUNING_METHODS[m];
+            // Powers of two, then every CPU if that is not one.
+            for (int workers = 1; workers <= cpus; workers = (workers == cpus) ?
+                cpus + 1 : (workers * 2 > cpus ? cpus : workers * 2))
+            {
+                // Only the threaded method tiles.
+                int tiles = (method == RELAX_METHOD_THREADS) ? tileSizes : 1;
+                for (int t = 0; t < tiles; t++)
+                {
+                    int tileSize = TUNING_TILE_SIZES[t];
+                    if (tileSize >= dimension)
+                    {
+                        continue;
+                    }
+
+                    RelaxSolver* solver = relaxCreate();
+                    if (solver == NULL)
+                    {
+                        return -1;
+                    }
+                    relaxSetDimension(solver, dimension);
+                    relaxSetPrecision(solver, precision);
+                    relaxSetMethod(solver, method);
+                    relaxSetWorkers(solver, workers);
+                    relaxSetTiling(solver, tileSize, 0.1);
+
+                    double seconds = runProbe(solver, bestSeconds);
+                    relaxDestroy(solver);
+
+                    printf("%4d x %-4d %-9s %2d workers, tiles %2d: ",
+                        dimension, dimension, relaxMethodName(method),
+                        workers, tileSize);
+                    if (seconds < 0.0)
+                    {
+                        printf("abandoned\n");
+                        continue;
+                    }
+                    printf("%f s\n", seconds);
+                    if (seconds < bestSeconds)
+                    {
+                        bestSeconds = seconds;
+                        best[s].method = method;
+                        best[s].workers = workers;
+                        best[s].tileSize = tileSize;
+                    }
+                }
+            }
+        }
+    }
+
+    const char* path = tuningFilePath();
+    FILE* file = fopen(path, "w");
+    if (file == NULL)
+    {
+        perror("fopen() error");
+        return -1;
+    }
+    fprintf(file, "# Written by --autotune at precision %g.\n", precision);
+    fprintf(file, "# CELLS METHOD WORKERS TILESIZE\n");
+    for (int s = 0; s < sizes; s++)
+    {
+        fprintf(file, "%ld %s %d %d\n",
+            (long) TUNING_DIMENSIONS[s] * TUNING_DIMENSIONS[s],
+            relaxMethodName(best[s].method), best[s].workers,
+            best[s].tileSize);
+    }
+    fclose(file);
+
+    printf("Saved tuning to: %s\n", path);
+    return 0;
+}
+
+bool loadTuning(long cells, TuningChoice* choice)
+{
+    FILE* file = fopen(tuningFilePath(), "r");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    // The entry whose size is nearest, by ratio, wins.
+    bool found = false;
+    double bestDistance = 0.0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        long entryCells;
+        char method[32];
+        int workers, tileSize;
+        if (line[0] == '#' || sscanf(line, "%ld %31s %d %d", &entryCells,
+            method, &workers, &tileSize) != 4 || entryCells < 1)
+        {
+            continue;
+        }
+
+        // Only the methods the tuner probes are taken.
+        int methods = (int) (sizeof(TUNING_METHODS) /
+            sizeof(TUNING_METHODS[0]));
+        int m = 0;
+        while (m < methods &&
+            strcmp(method, relaxMethodName(TUNING_METHODS[m])) != 0)
+        {
+            m++;
+        }
+        if (m == methods || workers < 1 || tileSize < 0)
+        {
+            continue;
+        }
+
+        double ratio = (double) cells / (double) entryCells;
+        double distance = ratio > 1.0 ? ratio : 1.0 / ratio;
+        if (!found || distance < bestDistance)
+        {
+            found = true;
+            bestDistance = distance;
+            choice->workers = workers;
+            choice->tileSize = tileSize;
+            choice->method = TUNING_METHODS[m];
+        }
+    }
+    fclose(file);
+    return found;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file tune.h
+ * @brief Header file for the autotuner: timed probes that pick the method,
+ * worker count and tile size for this host, saved to a per-host tuning file.
+ * @date 18/10/2026
+ * @author dancs-dev
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "../common/relax.h"
+
+
+typedef struct
+{
+    RelaxMethod method;
+    int workers;
+    int tileSize;
+} TuningChoice;
+
+
+// Probes every configuration on a few representative grid sizes, solving to
+// the given precision, and writes the fastest per size to the tuning file.
+int runAutotune(double precision);
+
+// Reads the choice tuned for the size nearest to a grid of the given number of
+// cells. Returns false if there is no tuning file for this host.
+bool loadTuning(long cells, TuningChoice* choice);
+
+// The file is $RELAX_TUNING_FILE if set, otherwise ~/.relax-tuning-HOSTNAME.
+const char* tuningFilePath(void);
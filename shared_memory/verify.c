@@ -0,0 +1,636 @@
+/**
+ * @file verify.c
+ * @brief Verification and performance harness for the shared memory solvers.
+ * @date 18/10/2026
+ * @author dancs-dev
+ *
+ * Compile using (after building librelax, see the README):
+ * gcc -o verify.out verify.c ../common/verify.c -L../common -lrelax -lpthread
+ * -lm -Wall -Wextra -Wconversion
+ *
+ * Run using: ./verify.out [-w MAXWORKERS] [-p PRECISION] [-e MAXERROR]
+ * [-l RMSERROR] [-n REPEATS] [-f FILTER] [-b BASELINE [-u] [-s THRESHOLD]]
+ * Example: ./verify.out -b baseline.txt
+ *
+ * Every method solves a matrix of grids (square, rectangular and a volume, with
+ * each 2D stencil) on 1, 2, 4, ... up to MAXWORKERS workers (default 4). Each
+ * result is compared in memory with the single threaded Jacobi reference for
+ * the same grid, and is wrong if the largest difference exceeds MAXERROR
+ * (default 1e-6) or the root mean square difference exceeds RMSERROR (default
+ * 2e-7). Both solves run to PRECISION (default 1e-11), so that the answers of
+ * the different methods agree far below the tolerances.
+ *
+ * Each grid is also solved warm, as the jacobi-warm case: from the result of a
+ * solve to a coarser precision, passed in with relaxSetInitialGuess. It must
+ * match the reference like any other method, in fewer sweeps.
+ *
+ * Each grid is also solved under several boundary configurations at once (see
+ * relax_fields.c), as the jacobi-fields case, and each field must match a
+ * Jacobi solve with its boundaries alone exactly. The jacobi-fields/limit case
+ * checks that more than RELAX_MAX_FIELDS configurations are refused.
+ *
+ * The chebyshev-estimate case checks that relaxGetJacobiEstimate after a
+ * Chebyshev solve of each grid matches the sweeps a Jacobi solve of it actually
+ * takes, at PRECISION and at the looser precisions in ESTIMATE_PRECISIONS, to
+ * within a sweep or ESTIMATE_TOLERANCE of them for rounding.
+ *
+ * Each case is solved REPEATS times (default 3). Every solve is checked, which
+ * catches intermittent races, and the fastest is its time to solution. With -b
+ * the times are compared with those stored in BASELINE, and a case taking more
+ * than THRESHOLD (default 0.2, i.e. 20%) longer is flagged as slower. -u writes
+ * the times of this run to BASELINE instead, keeping entries for cases that did
+ * not run. -f runs only the cases whose name contains FILTER, e.g. wavefront or
+ * /w4.
+ *
+ * Exits with 0 if every case passed, 1 if any was wrong, and otherwise 2 if
+ * any was slower than its baseline.
+ *
+ */
+
+
+// Standard header includes
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+// Project header includes
+#include "../common/relax.h"
+#include "../common/verify.h"
+
+
+typedef struct
+{
+    int rows;
+    int columns;
+    int planes;
+    const char* stencil;
+} VerifyGrid;
+
+typedef struct
+{
+    const char* name;
+    RelaxMethod method;
+    int tileSize;
+    bool adaptive;
+    // Methods that only ever run on one thread are not repeated per count.
+    bool singleThreaded;
+    bool only2D;
+} VerifyMethod;
+
+
+// The grids: an odd size, one with a specialised sweep, one large enough to
+// tile, a rectangle with every 2D stencil, and a volume.
+static const VerifyGrid GRIDS[] =
+{
+    { 5, 5, 1, "5" },
+    { 64, 64, 1, "5" },
+    { 97, 97, 1, "5" },
+    { 37, 50, 1, "5" },
+    { 37, 50, 1, "9" },
+    { 37, 50, 1, "weighted:1,4" },
+    { 9, 11, 17, "5" }
+};
+
+static const VerifyMethod METHODS[] =
+{
+    { "jacobi", RELAX_METHOD_JACOBI, 0, false, true, false },
+    { "threads", RELAX_METHOD_THREADS, 0, false, false, false },
+    { "threads-t16", RELAX_METHOD_THREADS, 16, false, false, true },
+    { "wavefront", RELAX_METHOD_WAVEFRONT, 0, false, false, false },
+    { "chebyshev", RELAX_METHOD_CHEBYSHEV, 0, false, false, false },
+    { "chebyshev-adaptive", RELAX_METHOD_CHEBYSHEV, 0, true, false, false },
+    { "direct", RELAX_METHOD_DIRECT, 0, false, false, true },
+    { "outofcore", RELAX_METHOD_OUT_OF_CORE, 0, false, true, false }
+};
+
+// The boundaries of the multi-field case. They converge after different
+// sweeps, so fields retire one or two at a time.
+static const RelaxBoundaries FIELDS[] =
+{
+    { 1.0, 1.0, 0.0, 0.0, 0.0, 0.0 },
+    { 0.0, 0.0, 1.0, 1.0, 0.0, 0.0 },
+    { 2.0, -1.0, 0.5, 0.0, 1.0, 0.0 },
+    { 0.25, 0.25, 0.25, 0.25, 0.25, 0.25 },
+    { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0 }
+};
+
+// The loose precisions at which the plain Jacobi estimate is also checked, where
+// the faster modes have not died away yet.
+static const double ESTIMATE_PRECISIONS[] = { 1e-2, 1e-3, 1e-4 };
+
+// The fraction of the sweeps by which the estimate may be off, besides one.
+#define ESTIMATE_TOLERANCE 0.01
+
+
+// Default settings
+double PRECISION    = 1e-11;
+int MAX_WORKERS     = 4;
+char* BASELINE      = NULL;
+bool UPDATE         = false;
+char* FILTER        = NULL;
+
+
+// Function declarations
+static RelaxSolver* createSolver(const VerifyGrid* grid);
+static int runCase(RelaxSolver* solver, const double* reference,
+    const VerifyOptions* options, VerifyErrors* errors, double* seconds);
+static int runWarmCase(const VerifyGrid* grid, const double* reference,
+    const VerifyOptions* options, VerifyErrors* errors, double* seconds,
+    int* sweeps);
+static int runFieldsCase(const VerifyGrid* grid, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds);
+static bool estimatesJacobiSweeps(const VerifyGrid* grid, const char* name,
+    int referenceSweeps);
+static bool refusesTooManyFields(void);
+static double secondsSince(const struct timespec* start);
+
+
+// Function definitions
+int main(int argc, char **argv)
+{
+    VerifyOptions options;
+    options.maxTolerance = 1e-6;
+    options.rmsTolerance = 2e-7;
+    options.threshold = 0.2;
+    options.repeats = 3;
+
+    int c;
+    while ((c = getopt(argc, argv, "w:p:e:l:n:f:b:us:")) != -1)
+    {
+        switch(c)
+        {
+            case 'w':
+                MAX_WORKERS = atoi(optarg);
+                if (MAX_WORKERS < 1)
+                {
+                    return -1;
+                }
+                break;
+
+            case 'p':
+                PRECISION = atof(optarg);
+                if (PRECISION <= 0.0 || PRECISION > 1.0)
+                {
+                    return -1;
+                }
+                break;
+
+            case 'e':
+                options.maxTolerance = atof(optarg);
+                break;
+
+            case 'l':
+                options.rmsTolerance = atof(optarg);
+                break;
+
+            case 'n':
+                options.repeats = atoi(optarg);
+                if (options.repeats < 1)
+                {
+                    return -1;
+                }
+                break;
+
+            case 'f':
+                FILTER = optarg;
+                break;
+
+            case 'b':
+                BASELINE = optarg;
+                break;
+
+            case 'u':
+                UPDATE = true;
+                break;
+
+            case 's':
+                options.threshold = atof(optarg);
+                if (options.threshold < 0.0)
+                {
+                    return -1;
+                }
+                break;
+
+            default:
+                return -1;
+        }
+    }
+    if (UPDATE && BASELINE == NULL)
+    {
+        fprintf(stderr, "-u needs a baseline file (-b)\n");
+        return -1;
+    }
+
+    Baseline baseline = { NULL, 0, 0 };
+    if (BASELINE != NULL && loadBaseline(&baseline, BASELINE) != 0)
+    {
+        return -1;
+    }
+
+    // The out-of-core method keeps its grid in a scratch file.
+    char store[] = "/tmp/relax-verify-XXXXXX";
+    int fd = mkstemp(store);
+    if (fd < 0)
+    {
+        perror("mkstemp() error");
+        return -1;
+    }
+    close(fd);
+
+    int grids = (int) (sizeof(GRIDS) / sizeof(GRIDS[0]));
+    int methods = (int) (sizeof(METHODS) / sizeof(METHODS[0]));
+    int cases = 0, wrong = 0, slower = 0;
+
+    for (int g = 0; g < grids; g++)
+    {
+        const VerifyGrid* grid = &GRIDS[g];
+
+        RelaxSolver* reference = createSolver(grid);
+        if (reference == NULL || relaxSolve(reference) != RELAX_OK)
+        {
+            fprintf(stderr, "Reference solve failed\n");
+            return -1;
+        }
+        const double* expected = relaxGetResult(reference, NULL);
+
+        for (int m = 0; m < methods; m++)
+        {
+            const VerifyMethod* method = &METHODS[m];
+            if (method->only2D && grid->planes > 1)
+            {
+                continue;
+            }
+
+            // Powers of two, then MAX_WORKERS if that is not one.
+            for (int workers = 1; workers <= MAX_WORKERS; workers =
+                (workers == MAX_WORKERS) ? MAX_WORKERS + 1 :
+                (workers * 2 > MAX_WORKERS ? MAX_WORKERS : workers * 2))
+            {
+                if (method->singleThreaded && workers > 1)
+                {
+                    break;
+                }
+
+                char name[64];
+                snprintf(name, sizeof(name), "%s/%dx%dx%d/%s/w%d",
+                    method->name, grid->rows, grid->columns, grid->planes,
+                    grid->stencil, workers);
+                if (FILTER != NULL && strstr(name, FILTER) == NULL)
+                {
+                    continue;
+                }
+
+                RelaxSolver* solver = createSolver(grid);
+                if (solver == NULL)
+                {
+                    return -1;
+                }
+                relaxSetMethod(solver, method->method);
+                relaxSetWorkers(solver, workers);
+                relaxSetTiling(solver, method->tileSize, 0.1);
+                relaxSetChebyshevAdaptive(solver, method->adaptive);
+                if (method->method == RELAX_METHOD_OUT_OF_CORE)
+                {
+                    relaxSetOutOfCore(solver, store, 4);
+                }
+
+                VerifyErrors errors;
+                double seconds;
+                if (runCase(solver, expected, &options, &errors, &seconds) !=
+                    RELAX_OK)
+                {
+                    fprintf(stderr, "%s: solve failed\n", name);
+                    return -1;
+                }
+                relaxDestroy(solver);
+
+                int outcome = reportCase(name, &errors, seconds,
+                    UPDATE ? NULL : &baseline, &options);
+                cases++;
+                wrong += (outcome & VERIFY_WRONG) ? 1 : 0;
+                slower += (outcome & VERIFY_SLOWER) ? 1 : 0;
+                if (UPDATE && recordBaseline(&baseline, name, seconds) != 0)
+                {
+                    return -1;
+                }
+            }
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "jacobi-warm/%dx%dx%d/%s/w1", grid->rows,
+            grid->columns, grid->planes, grid->stencil);
+        if (FILTER == NULL || strstr(name, FILTER) != NULL)
+        {
+            VerifyErrors errors;
+            double seconds;
+            int sweeps;
+            if (runWarmCase(grid, expected, &options, &errors, &seconds,
+                &sweeps) != RELAX_OK)
+            {
+                fprintf(stderr, "%s: solve failed\n", name);
+                return -1;
+            }
+            int outcome = reportCase(name, &errors, seconds,
+                UPDATE ? NULL : &baseline, &options);
+            // A guess this close saves sweeps, unless it was ignored.
+            if (sweeps >= relaxGetIterations(reference))
+            {
+                fprintf(stderr, "%s: %d sweeps, no fewer than from zero\n",
+                    name, sweeps);
+                outcome |= VERIFY_WRONG;
+            }
+            cases++;
+            wrong += (outcome & VERIFY_WRONG) ? 1 : 0;
+            slower += (outcome & VERIFY_SLOWER) ? 1 : 0;
+            if (UPDATE && recordBaseline(&baseline, name, seconds) != 0)
+            {
+                return -1;
+            }
+        }
+
+        snprintf(name, sizeof(name), "chebyshev-estimate/%dx%dx%d/%s/w1",
+            grid->rows, grid->columns, grid->planes, grid->stencil);
+        if (FILTER == NULL || strstr(name, FILTER) != NULL)
+        {
+            bool estimated = estimatesJacobiSweeps(grid, name,
+                relaxGetIterations(reference));
+            printf("%-44s %s\n", name, estimated ? "OK" : "WRONG");
+            cases++;
+            wrong += estimated ? 0 : 1;
+        }
+        relaxDestroy(reference);
+
+        snprintf(name, sizeof(name), "jacobi-fields/%dx%dx%d/%s/w1",
+            grid->rows, grid->columns, grid->planes, grid->stencil);
+        if (FILTER != NULL && strstr(name, FILTER) == NULL)
+        {
+            continue;
+        }
+        VerifyErrors errors;
+        double seconds;
+        if (runFieldsCase(grid, &options, &errors, &seconds) != RELAX_OK)
+        {
+            fprintf(stderr, "%s: solve failed\n", name);
+            return -1;
+        }
+        // Each field is swept exactly as on its own.
+        VerifyOptions exact = options;
+        exact.maxTolerance = 0.0;
+        exact.rmsTolerance = 0.0;
+        int outcome = reportCase(name, &errors, seconds,
+            UPDATE ? NULL : &baseline, &exact);
+        cases++;
+        wrong += (outcome & VERIFY_WRONG) ? 1 : 0;
+        slower += (outcome & VERIFY_SLOWER) ? 1 : 0;
+        if (UPDATE && recordBaseline(&baseline, name, seconds) != 0)
+        {
+            return -1;
+        }
+    }
+    unlink(store);
+
+    const char* limit = "jacobi-fields/limit";
+    if (FILTER == NULL || strstr(limit, FILTER) != NULL)
+    {
+        bool refused = refusesTooManyFields();
+        printf("%-44s %s\n", limit, refused ? "OK" : "WRONG");
+        cases++;
+        wrong += refused ? 0 : 1;
+    }
+
+    if (UPDATE)
+    {
+        if (saveBaseline(&baseline, BASELINE) != 0)
+        {
+            return -1;
+        }
+        printf("Saved baseline to: %s\n", BASELINE);
+    }
+    freeBaseline(&baseline);
+
+    return finishVerify(cases, wrong, slower);
+}
+
+// The reference configuration of a grid: Jacobi on one thread.
+static RelaxSolver* createSolver(const VerifyGrid* grid)
+{
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return NULL;
+    }
+    if (relaxSetExtents(solver, grid->rows, grid->columns, grid->planes) !=
+        RELAX_OK || relaxSetStencilByName(solver, grid->stencil) != RELAX_OK)
+    {
+        relaxDestroy(solver);
+        return NULL;
+    }
+    relaxSetPrecision(solver, PRECISION);
+    relaxSetMethod(solver, RELAX_METHOD_JACOBI);
+    return solver;
+}
+
+// Solves options->repeats times, keeping the largest errors and the fastest
+// time.
+static int runCase(RelaxSolver* solver, const double* reference,
+    const VerifyOptions* options, VerifyErrors* errors, double* seconds)
+{
+    int rows, columns, planes;
+    relaxGetExtents(solver, &rows, &columns, &planes);
+    size_t cells = (size_t) rows * (size_t) columns * (size_t) planes;
+
+    errors->maxError = 0.0;
+    errors->rmsError = 0.0;
+    *seconds = 0.0;
+    for (int r = 0; r < options->repeats; r++)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int status = relaxSolve(solver);
+        double elapsed = secondsSince(&start);
+        if (status != RELAX_OK)
+        {
+            return status;
+        }
+        if (r == 0 || elapsed < *seconds)
+        {
+            *seconds = elapsed;
+        }
+
+        VerifyErrors solve;
+        compareGrids(relaxGetResult(solver, NULL), reference, cells, &solve);
+        if (!(solve.maxError <= errors->maxError))
+        {
+            errors->maxError = solve.maxError;
+        }
+        if (!(solve.rmsError <= errors->rmsError))
+        {
+            errors->rmsError = solve.rmsError;
+        }
+    }
+    return RELAX_OK;
+}
+
+// Solves the grid to a thousand times PRECISION, then runs the reference
+// configuration as a case warm-started from that result. sweeps is set to the
+// sweeps of the last warm solve.
+static int runWarmCase(const VerifyGrid* grid, const double* reference,
+    const VerifyOptions* options, VerifyErrors* errors, double* seconds,
+    int* sweeps)
+{
+    RelaxSolver* coarse = createSolver(grid);
+    RelaxSolver* solver = createSolver(grid);
+    int status = (coarse == NULL || solver == NULL) ? RELAX_ERROR : RELAX_OK;
+    if (status == RELAX_OK)
+    {
+        relaxSetPrecision(coarse, PRECISION * 1000.0);
+        status = relaxSolve(coarse);
+    }
+    if (status == RELAX_OK)
+    {
+        relaxSetInitialGuess(solver, relaxGetResult(coarse, NULL));
+        status = runCase(solver, reference, options, errors, seconds);
+        *sweeps = relaxGetIterations(solver);
+    }
+    relaxDestroy(solver);
+    relaxDestroy(coarse);
+    return status;
+}
+
+// Solves the grid under every boundary configuration in FIELDS at once,
+// options->repeats times, comparing each field with a Jacobi solve with its
+// boundaries alone. Keeps the largest errors of any field and the fastest time.
+static int runFieldsCase(const VerifyGrid* grid, const VerifyOptions* options,
+    VerifyErrors* errors, double* seconds)
+{
+    int count = (int) (sizeof(FIELDS) / sizeof(FIELDS[0]));
+    size_t cells = (size_t) grid->rows * (size_t) grid->columns *
+        (size_t) grid->planes;
+    RelaxSolver* references[sizeof(FIELDS) / sizeof(FIELDS[0])];
+    RelaxSolver* solver = createSolver(grid);
+    int status = (solver == NULL) ? RELAX_ERROR :
+        relaxSetFields(solver, FIELDS, count);
+    for (int f = 0; f < count; f++)
+    {
+        references[f] = createSolver(grid);
+        if (status == RELAX_OK && (references[f] == NULL ||
+            relaxSetBoundaries(references[f], &FIELDS[f]) != RELAX_OK))
+        {
+            status = RELAX_ERROR;
+        }
+        if (status == RELAX_OK)
+        {
+            status = relaxSolve(references[f]);
+        }
+    }
+
+    errors->maxError = 0.0;
+    errors->rmsError = 0.0;
+    *seconds = 0.0;
+    for (int r = 0; r < options->repeats && status == RELAX_OK; r++)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status = relaxSolve(solver);
+        double elapsed = secondsSince(&start);
+        if (r == 0 || elapsed < *seconds)
+        {
+            *seconds = elapsed;
+        }
+
+        for (int f = 0; f < count && status == RELAX_OK; f++)
+        {
+            VerifyErrors field;
+            compareGrids(relaxGetFieldResult(solver, f),
+                relaxGetResult(references[f], NULL), cells, &field);
+            if (!(field.maxError <= errors->maxError))
+            {
+                errors->maxError = field.maxError;
+            }
+            if (!(field.rmsError <= errors->rmsError))
+            {
+                errors->rmsError = field.rmsError;
+            }
+        }
+    }
+
+    for (int f = 0; f < count; f++)
+    {
+        relaxDestroy(references[f]);
+    }
+    relaxDestroy(solver);
+    return status;
+}
+
+// Checks relaxGetJacobiEstimate after a Chebyshev solve of the grid against
+// the sweeps of a Jacobi solve: at each of ESTIMATE_PRECISIONS, and at
+// PRECISION, where the reference took referenceSweeps. Reports any mismatch under name.
+static bool estimatesJacobiSweeps(const VerifyGrid* grid, const char* name,
+    int referenceSweeps)
+{
+    int count = (int) (sizeof(ESTIMATE_PRECISIONS) /
+        sizeof(ESTIMATE_PRECISIONS[0]));
+    bool estimated = true;
+    for (int p = 0; p <= count; p++)
+    {
+        double precision = (p < count) ? ESTIMATE_PRECISIONS[p] : PRECISION;
+        int sweeps = referenceSweeps;
+        RelaxSolver* jacobi = (p < count) ? createSolver(grid) : NULL;
+        RelaxSolver* chebyshev = createSolver(grid);
+        int status = (chebyshev == NULL || (p < count && jacobi == NULL)) ?
+            RELAX_ERROR : RELAX_OK;
+        if (status == RELAX_OK && jacobi != NULL)
+        {
+            relaxSetPrecision(jacobi, precision);
+            status = relaxSolve(jacobi);
+            sweeps = relaxGetIterations(jacobi);
+        }
+        if (status == RELAX_OK)
+        {
+            relaxSetPrecision(chebyshev, precision);
+            relaxSetMethod(chebyshev, RELAX_METHOD_CHEBYSHEV);
+            status = relaxSolve(chebyshev);
+        }
+        int estimate = (status == RELAX_OK) ?
+            relaxGetJacobiEstimate(chebyshev) : 0;
+        relaxDestroy(chebyshev);
+        relaxDestroy(jacobi);
+
+        if (abs(estimate - sweeps) > 1 + (int) (sweeps * ESTIMATE_TOLERANCE))
+        {
+            fprintf(stderr, "%s: estimated %d sweeps at precision %g, Jacobi "
+                "took %d\n", name, estimate, precision, sweeps);
+            estimated = false;
+        }
+    }
+    return estimated;
+}
+
+// Checks that a solver takes RELAX_MAX_FIELDS boundary configurations but
+// refuses one more, which the multi-field kernels have no room for.
+static bool refusesTooManyFields(void)
+{
+    static const RelaxBoundaries tooMany[RELAX_MAX_FIELDS + 1];
+    RelaxSolver* solver = relaxCreate();
+    if (solver == NULL)
+    {
+        return false;
+    }
+    bool refused = relaxSetFields(solver, tooMany, RELAX_MAX_FIELDS) ==
+        RELAX_OK && relaxSetFields(solver, tooMany, RELAX_MAX_FIELDS + 1) ==
+        RELAX_ERROR;
+    relaxDestroy(solver);
+    return refused;
+}
+
+static double secondsSince(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        ((double) (now.tv_nsec - start->tv_nsec) / 1e9);
+}